@@ -2,8 +2,11 @@
 
 #include "DamnationGameModeBase.h"
 #include "ProjectileInterface.h"
+#include "DungeonPathBenchmark.h"
+#include "Misc/CommandLine.h"
+#include "Misc/Parse.h"
 
-void ADamnationGameModeBase::InitDungeonMap(bool bSpawnPlayer)
+void ADamnationGameModeBase::InitDungeonMap(bool bSpawnPlayer, bool bTimeSliced)
 {
 	auto world = GetWorld();
 
@@ -16,7 +19,17 @@ void ADamnationGameModeBase::InitDungeonMap(bool bSpawnPlayer)
 		ActivePlayer->SetGamemode(this);
 	}
 
+	SeedFloor();
 	BindColorMapEvents();
+	// The grid places the eyes & generates the minimap itself, then calls OnDungeonMapGenerated
+	if (bTimeSliced && DungeonMap)
+	{
+		DungeonMap->SetGamemode(this);
+		DungeonMap->OnFloorGenerated.AddUniqueDynamic(this, &ADamnationGameModeBase::OnDungeonMapGenerated);
+		DungeonMap->GenerateFloorTimeSliced();
+		return;
+	}
+
 	// Map of the game world
 	if (DungeonMap)
 	{
@@ -33,6 +46,13 @@ void ADamnationGameModeBase::InitDungeonMap(bool bSpawnPlayer)
 	BeginGame();
 }
 
+void ADamnationGameModeBase::OnDungeonMapGenerated()
+{
+	DungeonMap->OnFloorGenerated.RemoveDynamic(this, &ADamnationGameModeBase::OnDungeonMapGenerated);
+	// Call BP logic once the game is prepared
+	BeginGame();
+}
+
 void ADamnationGameModeBase::InitBossMap()
 {
 	auto world = GetWorld();
@@ -42,6 +62,7 @@ void ADamnationGameModeBase::InitBossMap()
 	spawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
 	ActivePlayer = GetWorld()->SpawnActor<ADungeonCrawlerPlayer>(PlayerActorType, spawnParams);
 
+	SeedFloor();
 	BindColorMapEvents();
 	// Map of the boss room
 	if (DungeonMap)
@@ -51,36 +72,154 @@ void ADamnationGameModeBase::InitBossMap()
 	}
 }
 
+void ADamnationGameModeBase::BeginPlay()
+{
+	Super::BeginPlay();
+	ActorSpawnedHandle = GetWorld()->AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &ADamnationGameModeBase::OnActorSpawned));
+}
+
+void ADamnationGameModeBase::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	GetWorld()->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+	GetWorldTimerManager().ClearTimer(RespawnTimerHandle);
+	RespawnScheduler.Reset();
+	Super::EndPlay(EndPlayReason);
+}
+
+void ADamnationGameModeBase::OnActorSpawned(AActor* actor)
+{
+	TurnProfiler.AddActorSpawned();
+}
+
 void ADamnationGameModeBase::DoEnemyMovement()
 {
-	for (auto enemy : ActiveEnemies)
+	DUNGEON_SCOPE_CYCLE_COUNTER(STAT_DungeonTurn);
+	TurnProfiler.BeginTurn(DungeonMap ? DungeonMap->GetPathRequestCount() : 0, DungeonMap ? DungeonMap->GetPathExpandedCount() : 0);
+
 	{
-		enemy->PerformMovement();
+		DUNGEON_SCOPE_CYCLE_COUNTER(STAT_DungeonEnemyMovement);
+		// Built once for the turn; enemies moving don't change it, so every later read is free
+		UpdatePlayerFlowField();
+		ResolveEnemyTurn();
+		for (auto enemy : ActiveEnemies)
+		{
+			if (enemy->UsesNativeMovement())
+				continue;
+			enemy->PerformMovement();
+			TurnProfiler.AddEnemyMoved();
+		}
 	}
 	CleanupDeadEnemies();
 
-	TArray<AActor*> projectilesToDelete;
-	projectilesToDelete.Reserve(ActiveProjectiles.Num());
+	{
+		DUNGEON_SCOPE_CYCLE_COUNTER(STAT_DungeonProjectileActions);
+		TArray<AActor*> projectilesToDelete;
+		projectilesToDelete.Reserve(ActiveProjectiles.Num());
+
+		for (auto projectile : ActiveProjectiles)
+		{
+			if (IProjectileInterface::Execute_ProjectileAction(projectile))
+				projectilesToDelete.Add(projectile);
+		}
+		// Destroy projectiles that are set to be destroyed
+		for (AActor* projectile : projectilesToDelete)
+		{
+			ActiveProjectiles.RemoveSwap(projectile);
+			projectile->Destroy();
+		}
+	}
+
+	// Set last players' position
+	LastTile = ActivePlayer->CurrentTile;
+	{
+		DUNGEON_SCOPE_CYCLE_COUNTER(STAT_DungeonPlayerAction);
+		PlayerAction();
+	}
+
+	TurnProfiler.EndTurn(DungeonMap ? DungeonMap->GetPathRequestCount() : 0, DungeonMap ? DungeonMap->GetPathExpandedCount() : 0);
+}
 
-	for (auto projectile : ActiveProjectiles)
+void ADamnationGameModeBase::ResolveEnemyTurn()
+{
+	NativeEnemies.Reset();
+	EnemyIntents.Reset();
+	if (!DungeonMap || !ActivePlayer || !ActivePlayer->CurrentTile || ActivePlayer->CurrentTile->TileIndex == INDEX_NONE)
+		return;
+	for (ADungeonCrawlerEnemy* enemy : ActiveEnemies)
 	{
-		if (IProjectileInterface::Execute_ProjectileAction(projectile))
-			projectilesToDelete.Add(projectile);
+		// Enemies killed last turn stay in ActiveEnemies until CleanupDeadEnemies, they mustn't move or claim tiles
+		if (enemy->IsPendingKill() || ToBeKilledEnemies.Contains(enemy))
+			continue;
+		if (enemy->UsesNativeMovement() && enemy->CurrentTile && enemy->CurrentTile->TileIndex != INDEX_NONE)
+			NativeEnemies.Add(enemy);
 	}
-	// Destroy projectiles that are set to be destroyed
-	for (AActor* projectile : projectilesToDelete)
+	if (NativeEnemies.Num() == 0)
+		return;
+
+	// DoEnemyMovement has already brought the flow field up to date for this turn
+	for (ADungeonCrawlerEnemy* enemy : NativeEnemies)
 	{
-		ActiveProjectiles.RemoveSwap(projectile);
-		projectile->Destroy();
+		FDungeonEnemyIntent& intent = EnemyIntents[EnemyIntents.AddDefaulted()];
+		intent.Tile = enemy->CurrentTile->TileIndex;
+		// Enemies outside the flow field follow their own path. Any new ones are searched for while deciding
+		if (PlayerFlowField.GetNextStep(intent.Tile) == INDEX_NONE)
+		{
+			intent.bRepath = enemy->NeedsRepath(ActivePlayer->CurrentTile);
+			intent.PathStep = enemy->GetPathStep();
+		}
 	}
 
-	// Set last players' position
-	LastTile = ActivePlayer->CurrentTile;
-	PlayerAction();
+	// Nothing else touches the graph or field until every intent is decided, so space must be current first
+	DungeonMap->UpdateRoomGraph();
+	const FDungeonTileGraph& graph = DungeonMap->GetTileGraph();
+	ADungeonMacroGrid* map = DungeonMap;
+	FDungeonPathContextPool& contexts = DungeonMap->GetPathContexts();
+	FDungeonTurnResolver::Decide(graph, PlayerFlowField, ActivePlayer->CurrentTile->TileIndex, EnemyIntents,
+		[map, &contexts](int32 start, int32 end, TArray<int32>& outPath)
+		{
+			FDungeonScopedPathContext context(contexts);
+			return map->GeneratePath(context.Get(), start, end, outPath, 1, true, true);
+		});
+
+	// Paths found while deciding are only indices, tiles may need spawning so that's done back here
+	TArray<ADungeonSingleTile*> path;
+	for (int32 i = 0; i < EnemyIntents.Num(); ++i)
+	{
+		if (!EnemyIntents[i].bRepath)
+			continue;
+		graph.ToTiles(EnemyIntents[i].Path, path);
+		NativeEnemies[i]->SetDesiredPath(path);
+	}
+
+	FDungeonTurnResolver::GetCommitOrder(EnemyIntents, EnemyCommitOrder);
+	for (int32 i : EnemyCommitOrder)
+	{
+		if (!FDungeonTurnResolver::CanCommit(graph, EnemyIntents[i]))
+			continue;
+		NativeEnemies[i]->CommitMove(DungeonMap->GetTileByTileIndex(EnemyIntents[i].Target), (ECardinal)EnemyIntents[i].Direction);
+		TurnProfiler.AddEnemyMoved();
+	}
+
+	// Blueprint reactions wait until every enemy has moved, so they see the end of the turn
+	for (int32 i : EnemyCommitOrder)
+	{
+		ADungeonCrawlerEnemy* enemy = NativeEnemies[i];
+		if (enemy->IsPendingKill())
+			continue;
+		enemy->ReceiveTurnResolved(EnemyIntents[i].Action, DungeonMap->GetTileByTileIndex(EnemyIntents[i].Target));
+	}
+}
+
+void ADamnationGameModeBase::DumpTurnStats(bool bReset)
+{
+	TurnProfiler.LogHistogram();
+	if (bReset)
+		TurnProfiler.Reset();
 }
 
 void ADamnationGameModeBase::CleanupDeadEnemies()
 {
+	DUNGEON_SCOPE_CYCLE_COUNTER(STAT_DungeonCleanupDeadEnemies);
 	for (ADungeonCrawlerEnemy* enemy : ToBeKilledEnemies)
 	{
 		if (enemy)
@@ -93,6 +232,7 @@ void ADamnationGameModeBase::CleanupDeadEnemies()
 
 void ADamnationGameModeBase::DoTormentorAction()
 {
+	DUNGEON_SCOPE_CYCLE_COUNTER(STAT_DungeonTormentorMovement);
 	if (ActiveTormentor)
 	{
 		ActiveTormentor->PerformMovement();
@@ -104,11 +244,111 @@ TArray<ADungeonSingleTile*> ADamnationGameModeBase::CallPathfinder(ADungeonSingl
 	return DungeonMap->GeneratePath(start, end, size, GoForClosest, respectOccupants);
 }
 
+int32 ADamnationGameModeBase::CallPathfinderAsync(ADungeonSingleTile* start, ADungeonSingleTile* end, FPathfinderResult onComplete, int size, bool GoForClosest, bool respectOccupants)
+{
+	if (!DungeonMap)
+		return INDEX_NONE;
+	FDungeonAsyncPathHandle request = DungeonMap->GeneratePathAsync(start, end, size, GoForClosest, respectOccupants, [onComplete](const FDungeonAsyncPathRequest& result)
+	{
+		TArray<ADungeonSingleTile*> path;
+		result.GetPathTiles(path);
+		onComplete.ExecuteIfBound(result.GetId(), path);
+	});
+	return request ? request->GetId() : INDEX_NONE;
+}
+
+void ADamnationGameModeBase::CancelPathfinderRequest(int32 requestId)
+{
+	if (DungeonMap)
+		DungeonMap->CancelPathAsync(requestId);
+}
+
+bool ADamnationGameModeBase::UpdatePlayerFlowField()
+{
+	DUNGEON_SCOPE_CYCLE_COUNTER(STAT_DungeonFlowField);
+	if (!DungeonMap || !ActivePlayer || !ActivePlayer->CurrentTile || ActivePlayer->CurrentTile->TileIndex == INDEX_NONE)
+	{
+		PlayerFlowField.Invalidate();
+		return false;
+	}
+	PlayerFlowField.Update(DungeonMap->GetTileGraph(), ActivePlayer->CurrentTile->TileIndex, FlowFieldRadius, FDungeonTileGraph::MakeOccupantHandle(ActivePlayer));
+	return true;
+}
+
+ADungeonSingleTile* ADamnationGameModeBase::GetFlowFieldStep(ADungeonSingleTile* tile)
+{
+	if (!tile || tile->TileIndex == INDEX_NONE || !UpdatePlayerFlowField())
+		return nullptr;
+	return DungeonMap->GetTileByTileIndex(PlayerFlowField.GetNextStep(DungeonMap->GetTileGraph(), tile->TileIndex));
+}
+
+bool ADamnationGameModeBase::GetFlowFieldPath(ADungeonSingleTile* start, TArray<ADungeonSingleTile*>& outPath)
+{
+	if (!start || start->TileIndex == INDEX_NONE || !UpdatePlayerFlowField())
+		return false;
+	const FDungeonTileGraph& graph = DungeonMap->GetTileGraph();
+	int32 next = PlayerFlowField.GetNextStep(graph, start->TileIndex);
+	if (next == INDEX_NONE)
+		return false;
+
+	outPath.Reset();
+	for (; next != INDEX_NONE; next = PlayerFlowField.GetNextStep(graph, next))
+		outPath.Add(DungeonMap->GetTileByTileIndex(next));
+	return true;
+}
+
+void ADamnationGameModeBase::BenchmarkPathfinding(int32 QueryCount)
+{
+	if (!DungeonMap)
+		return;
+	FDungeonPathBenchmark::LogResult(TEXT("Pathfinding size 1"), FDungeonPathBenchmark::Run(DungeonMap, QueryCount, 1));
+	FDungeonPathBenchmark::LogResult(TEXT("Pathfinding size 3"), FDungeonPathBenchmark::Run(DungeonMap, QueryCount, 3));
+}
+
+void ADamnationGameModeBase::ScheduleRespawnCheck(ADungeonRoomTileBase* room, float delay)
+{
+	RespawnScheduler.Schedule(room, GetWorld()->GetTimeSeconds() + delay);
+	UpdateRespawnTimer();
+}
+
+void ADamnationGameModeBase::CancelRespawnCheck(ADungeonRoomTileBase* room)
+{
+	RespawnScheduler.Cancel(room);
+	UpdateRespawnTimer();
+}
+
+void ADamnationGameModeBase::ProcessRespawnChecks()
+{
+	const float now = GetWorld()->GetTimeSeconds();
+	DueRespawnRooms.Reset();
+	RespawnScheduler.PopDue(now, DueRespawnRooms);
+
+	// Every room due this time checks against the same player position
+	const bool bPlayerActive = ActivePlayer != nullptr;
+	const FVector playerLocation = bPlayerActive ? ActivePlayer->GetActorLocation() : FVector::ZeroVector;
+	for (ADungeonRoomTileBase* room : DueRespawnRooms)
+		RespawnScheduler.Schedule(room, now + room->CheckRespawns(bPlayerActive, playerLocation));
+	UpdateRespawnTimer();
+}
+
+void ADamnationGameModeBase::UpdateRespawnTimer()
+{
+	float nextTime;
+	if (!RespawnScheduler.GetNextTime(nextTime))
+	{
+		GetWorldTimerManager().ClearTimer(RespawnTimerHandle);
+		return;
+	}
+	// A timer with no delay is cleared rather than set, so anything overdue runs next frame
+	const float delay = FMath::Max(nextTime - GetWorld()->GetTimeSeconds(), KINDA_SMALL_NUMBER);
+	GetWorldTimerManager().SetTimer(RespawnTimerHandle, this, &ADamnationGameModeBase::ProcessRespawnChecks, delay, false);
+}
+
 void ADamnationGameModeBase::SetPlayerLocation(ADungeonSingleTile* target)
 {
 	if (target)
 	{
-		target->OccupyingActor = ActivePlayer;
+		target->SetOccupyingActor(ActivePlayer);
 		ActivePlayer->CurrentTile = target;
 		ActivePlayer->SetActorLocation(target->GetActorLocation());
 	}
@@ -141,7 +381,7 @@ void ADamnationGameModeBase::DespawnEnemies()
 	Algo::Reverse(DespawnList);
 	for (auto i : DespawnList)
 	{
-		ActiveEnemies[i]->CurrentTile->OccupyingActor = nullptr;
+		ActiveEnemies[i]->CurrentTile->SetOccupyingActor(nullptr);
 		ActiveEnemies[i]->Destroy();
 		ActiveEnemies.RemoveAt(i, 1, false);
 	}
@@ -149,6 +389,26 @@ void ADamnationGameModeBase::DespawnEnemies()
 	// Any remaining enemies in the list are close enough to the player that despawning them would look weird
 }
 
+void ADamnationGameModeBase::SeedFloor()
+{
+	int32 seed = FixedFloorSeed;
+	if (!FParse::Value(FCommandLine::Get(), TEXT("DungeonSeed="), seed) && seed == 0)
+	{
+		// Not drawn from the global stream, which may have been seeded for something else
+		FRandomStream source;
+		source.GenerateNewSeed();
+		seed = source.GetCurrentSeed();
+	}
+	FloorSeed = seed;
+	Random.Initialize(GetStreamSeed(EDungeonRandomStream::GAMEMODE));
+	UE_LOG(LogTemp, Display, TEXT("Dungeon floor seed: %d"), FloorSeed);
+}
+
+int32 ADamnationGameModeBase::MakeStreamSeed(int32 floorSeed, EDungeonRandomStream stream, int32 index)
+{
+	return (int32)HashCombine(HashCombine(GetTypeHash(floorSeed), GetTypeHash((uint8)stream)), GetTypeHash(index));
+}
+
 void ADamnationGameModeBase::GenerateMinimap_Implementation()
 {
 }
@@ -173,7 +433,7 @@ void ADamnationGameModeBase::PlaceEyes(ADungeonRoomTileBase* ReqRoom)
 	TArray<FVector> EyePositions;
 	EyePositions.Reserve(EyeSpawns.Num());
 	float MinDistSquared = FMath::Square(EyeSpacingDistance);
-	ShuffleArray(EyeSpawns);
+	ShuffleArray(EyeSpawns, Random);
 
 	// Picks eye spawns at random that aren't too close to each other
 	for (int e = EyeCount; e > 0; --e)
@@ -187,7 +447,7 @@ void ADamnationGameModeBase::PlaceEyes(ADungeonRoomTileBase* ReqRoom)
 				EyeCount = (EyeCount - e);
 				break;
 			}
-			int idx = FMath::RandRange(0, EyeSpawns.Num() - 1);
+			int idx = Random.RandRange(0, EyeSpawns.Num() - 1);
 			// If the eye spawn world position is too close to an existing eye location.
 			FVector worldPosition = EyeSpawns[idx].Value->GetRoomTilePosition(EyeSpawns[idx].Key);
 			bool valid = true;
@@ -7,8 +7,48 @@
 #include "Kismet/KismetMathLibrary.h"
 #include "DungeonMacroGrid.h"
 #include "DungeonCrawlerPlayer.h"
+#include "DungeonFlowField.h"
+#include "DungeonStats.h"
+#include "DungeonRespawnScheduler.h"
+#include "DungeonInterpolationManager.h"
 #include "DamnationGameModeBase.generated.h"
 
+// The random streams split from a floor seed, one per system so each is unaffected by how much the others draw.
+enum class EDungeonRandomStream : uint8
+{
+	GAMEMODE,
+	LAYOUT,
+	GRID,
+	ROOM,
+	TORMENTOR
+};
+
+// Built in handling for a room map colour, run natively instead of through a Blueprint delegate.
+// Every action adds a tile at the pixels' position first.
+UENUM(BlueprintType)
+enum class ETileColorAction : uint8
+{
+	ADDTILE = 0 UMETA(DisplayName = "Add Tile"),
+	ENEMYSPAWN = 1 UMETA(DisplayName = "Enemy Spawn"),
+	EYESPAWN = 2 UMETA(DisplayName = "Eye Spawn"),
+	TORMENTORSPAWN = 3 UMETA(DisplayName = "Tormentor Spawn"),
+	PLAYERSPAWN = 4 UMETA(DisplayName = "Player Spawn")
+};
+
+USTRUCT(BlueprintType)
+struct FTileColorAction
+{
+	GENERATED_BODY()
+
+public:
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	ETileColorAction Action = ETileColorAction::ADDTILE;
+
+	// Enemy spawns only, the type of enemy to spawn.
+	UPROPERTY(BlueprintReadWrite, EditAnywhere)
+	TSubclassOf<ADungeonCrawlerEnemy> EnemyType;
+};
+
 /**
  * 
  */
@@ -22,8 +62,9 @@ public:
 	ADungeonMacroGrid* DungeonMap = nullptr;
 
 	// Randomly generates a dungeon map using tiles in the macro grid.
+	// If bTimeSliced, the map is generated over several frames & BeginGame is called once it's complete.
 	UFUNCTION(BlueprintCallable)
-	void InitDungeonMap(bool bSpawnPlayer = true);
+	void InitDungeonMap(bool bSpawnPlayer = true, bool bTimeSliced = false);
 
 	// Generate the boss room map grid.
 	UFUNCTION(BlueprintCallable)
@@ -42,6 +83,41 @@ public:
 	UFUNCTION(BlueprintCallable)
 	TArray<ADungeonSingleTile*> CallPathfinder(ADungeonSingleTile* start, ADungeonSingleTile* end, int size = 1, bool GoForClosest = true, bool respectOccupants = false);
 
+	DECLARE_DYNAMIC_DELEGATE_TwoParams(FPathfinderResult, int32, requestId, const TArray<ADungeonSingleTile*>&, path);
+
+	// Same as CallPathfinder, but searches on a worker thread & calls onComplete with the path on a later frame.
+	// Returns the requests' id for cancelling it, -1 if it couldn't be made.
+	UFUNCTION(BlueprintCallable)
+	int32 CallPathfinderAsync(ADungeonSingleTile* start, ADungeonSingleTile* end, FPathfinderResult onComplete, int size = 1, bool GoForClosest = true, bool respectOccupants = false);
+
+	// Stops an async pathfinder request, its callback won't be called. Use when the result is no longer wanted.
+	UFUNCTION(BlueprintCallable)
+	void CancelPathfinderRequest(int32 requestId);
+
+	// Gets the next tile toward the player from tile using the shared flow field.
+	// Returns nullptr if tile is the players' tile, further than FlowFieldRadius or can't reach the player.
+	UFUNCTION(BlueprintPure)
+	ADungeonSingleTile* GetFlowFieldStep(ADungeonSingleTile* tile);
+
+	// Follows the shared flow field from start to the player, filling outPath the same way CallPathfinder would.
+	// Returns false if start is outside the field, outPath is left untouched.
+	bool GetFlowFieldPath(ADungeonSingleTile* start, TArray<ADungeonSingleTile*>& outPath);
+
+	// Console command. Times random pathfinding queries across the current floor for 1x1 & 3x3 pathers and logs the results.
+	UFUNCTION(Exec)
+	void BenchmarkPathfinding(int32 QueryCount = 1000);
+
+	// Console command. Logs a latency histogram of the most recent turns, with their average counts.
+	// Use "stat Damnation" for the time spent in each phase of a turn.
+	UFUNCTION(Exec)
+	void DumpTurnStats(bool bReset = false);
+
+	// Queues rooms' respawn check to run after delay seconds of game time, replacing any already queued.
+	void ScheduleRespawnCheck(ADungeonRoomTileBase* room, float delay);
+
+	// Stops a rooms' queued respawn check. Used when the room is reset for reuse.
+	void CancelRespawnCheck(ADungeonRoomTileBase* room);
+
 	UFUNCTION(BlueprintCallable)
 	void SetPlayerLocation(ADungeonSingleTile* target);
 
@@ -71,6 +147,20 @@ public:
 	// Place eyes in the map
 	void PlaceEyes(ADungeonRoomTileBase* ReqRoom = nullptr);
 
+	// Picks & logs the seed for a new floor: -DungeonSeed= on the command line if given, else FixedFloorSeed if non-zero, else random.
+	// Called by InitDungeonMap & InitBossMap before generating.
+	UFUNCTION(BlueprintCallable)
+	void SeedFloor();
+
+	// The seed every random stream of the current floor is split from.
+	UFUNCTION(BlueprintPure)
+	int32 GetFloorSeed() const { return FloorSeed; }
+
+	// The seed for one of the current floors' random streams. index separates streams of the same kind, e.g. per room.
+	int32 GetStreamSeed(EDungeonRandomStream stream, int32 index = 0) const { return MakeStreamSeed(FloorSeed, stream, index); }
+
+	static int32 MakeStreamSeed(int32 floorSeed, EDungeonRandomStream stream, int32 index = 0);
+
 	UPROPERTY(BlueprintReadWrite)
 	TSubclassOf<class ADungeonSingleTile> TileType;
 
@@ -78,6 +168,10 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	int EyeCount = 6;
 
+	// Seed used for every floor when non-zero, for reproducing a run. Overridden by -DungeonSeed= on the command line.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dungeon Variables|Seeding")
+	int32 FixedFloorSeed = 0;
+
 	// The minimum distance between each eye.
 	UPROPERTY(EditDefaultsOnly)
 	float EyeSpacingDistance = 1000.0f;
@@ -86,6 +180,10 @@ public:
 	UPROPERTY(EditDefaultsOnly)
 	float DespawnDistance = 1500.0f;
 
+	// How far, in steps, the flow field toward the player extends. Enemies further than this pathfind individually.
+	UPROPERTY(EditDefaultsOnly, Category = "Dungeon Variables|Pathfinding")
+	float FlowFieldRadius = 30.0f;
+
 	// The type to spawn on green tiles
 	UPROPERTY(EditDefaultsOnly, Category = "Dungeon Variables|Required Class Types")
 	TSubclassOf<ADungeonCrawlerPlayer> PlayerActorType;
@@ -125,8 +223,21 @@ public:
 		return FColor(InR, InG, InB);
 	}
 
+	// Handles color natively, taking priority over any delegate added for it.
+	UFUNCTION(BlueprintCallable)
+	void AddNativeColorMap(FColor color, FTileColorAction action)
+	{
+		NativeColorMap.Add(color, action);
+	}
+
 	TMap<FColor, FTileColorSpawn> ColorDelegateMap;
 
+	// Colors handled without going through Blueprint. Use for the common colors; delegates are for anything custom.
+	// Rooms apply these in batches: every tile first, then the spawns, then any delegates for the remaining colors.
+	// Enemy spawns are gathered per room & spawned by the room once loaded, so shouldn't also be passed to SpawnEnemies.
+	UPROPERTY(EditDefaultsOnly, Category = "Dungeon Variables|Map Colors")
+	TMap<FColor, FTileColorAction> NativeColorMap;
+
 	UPROPERTY(BlueprintReadOnly)
 	ADungeonCrawlerPlayer* ActivePlayer;
 	UPROPERTY(BlueprintReadOnly)
@@ -146,7 +257,57 @@ public:
 	UPROPERTY(BlueprintReadOnly)
 	TArray<ADungeonSingleTile*> TormentorSpawnLocations;
 
+	// Moves the lagged roots of occupants mid-action, see ADungeonTileOccupant::WakeInterpolation
+	FDungeonInterpolationManager Interpolation;
+
 	TArray<TPair<FVector2D, ADungeonRoomTileBase*>> EyeSpawns;
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
 	TArray<ADungeonSingleTile*> ActiveEyeTiles;
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Counts actors spawned during a turn
+	void OnActorSpawned(AActor* actor);
+
+	// Finishes a time sliced InitDungeonMap.
+	UFUNCTION()
+	void OnDungeonMapGenerated();
+
+	// Moves every enemy using native movement: each decides its move in parallel, then the moves are applied in a fixed order.
+	// Moves onto a tile taken earlier in the turn are blocked.
+	void ResolveEnemyTurn();
+
+	// Brings the player flow field up to date. Only searches if the player or floor changed since the last call.
+	bool UpdatePlayerFlowField();
+
+	// Runs the respawn check of every room that's due, requeues them & waits for the next one.
+	void ProcessRespawnChecks();
+
+	// Sets the respawn timer for the next queued check, or clears it if none are queued.
+	void UpdateRespawnTimer();
+
+	// When each room next checks for respawns
+	FDungeonRespawnScheduler RespawnScheduler;
+	FTimerHandle RespawnTimerHandle;
+	// Reused by ProcessRespawnChecks
+	TArray<ADungeonRoomTileBase*> DueRespawnRooms;
+
+	// Distance field toward the players' tile, shared by every enemy
+	FDungeonFlowField PlayerFlowField;
+
+	// Reused by ResolveEnemyTurn, NativeEnemies[i] is the enemy of EnemyIntents[i]
+	TArray<ADungeonCrawlerEnemy*> NativeEnemies;
+	TArray<FDungeonEnemyIntent> EnemyIntents;
+	TArray<int32> EnemyCommitOrder;
+
+	// Timing & counts of recent DoEnemyMovement turns
+	FDungeonTurnProfiler TurnProfiler;
+	FDelegateHandle ActorSpawnedHandle;
+
+	int32 FloorSeed = 0;
+
+	// Eye placement
+	FRandomStream Random;
 };
@@ -0,0 +1,82 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DungeonActorPool.h"
+#include "Engine/World.h"
+
+AActor* FDungeonActorPool::Acquire(UWorld* world, UClass* type, const FTransform& transform)
+{
+	if (!world || !type)
+		return nullptr;
+
+	FClassPool& pool = Pools.FindOrAdd(type);
+	AActor* actor = nullptr;
+	while (!actor && pool.Free.Num() > 0)
+		actor = pool.Free.Pop(false).Get();
+
+	if (actor)
+	{
+		actor->SetActorTransform(transform, false, nullptr, ETeleportType::TeleportPhysics);
+		actor->SetActorHiddenInGame(false);
+		actor->SetActorEnableCollision(true);
+		actor->SetActorTickEnabled(actor->PrimaryActorTick.bStartWithTickEnabled);
+		++pool.Stats.Reused;
+	}
+	else
+	{
+		FActorSpawnParameters spawnParams;
+		spawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		actor = world->SpawnActor<AActor>(type, transform, spawnParams);
+		if (!actor)
+			return nullptr;
+		++pool.Stats.Spawned;
+	}
+
+	++pool.Stats.InUse;
+	pool.Stats.HighWater = FMath::Max(pool.Stats.HighWater, pool.Stats.InUse);
+	return actor;
+}
+
+void FDungeonActorPool::Release(AActor* actor)
+{
+	if (!actor || actor->IsPendingKill())
+		return;
+
+	actor->SetActorHiddenInGame(true);
+	actor->SetActorEnableCollision(false);
+	actor->SetActorTickEnabled(false);
+
+	FClassPool& pool = Pools.FindOrAdd(actor->GetClass());
+	pool.Free.Add(actor);
+	// Actors spawned before pooling was used aren't counted as in use
+	pool.Stats.InUse = FMath::Max(pool.Stats.InUse - 1, 0);
+}
+
+void FDungeonActorPool::Empty()
+{
+	for (TPair<UClass*, FClassPool>& pool : Pools)
+	{
+		for (const TWeakObjectPtr<AActor>& actor : pool.Value.Free)
+			if (actor.IsValid())
+				actor->Destroy();
+		pool.Value.Free.Empty();
+	}
+}
+
+FDungeonActorPool::FStats FDungeonActorPool::GetStats(UClass* type) const
+{
+	const FClassPool* pool = Pools.Find(type);
+	if (!pool)
+		return FStats();
+	FStats stats = pool->Stats;
+	stats.Free = pool->Free.Num();
+	return stats;
+}
+
+void FDungeonActorPool::LogStats() const
+{
+	for (const TPair<UClass*, FClassPool>& pool : Pools)
+	{
+		UE_LOG(LogTemp, Display, TEXT("Actor pool %s: %d in use, %d free, high water %d, %d spawned, %d reused"), *GetNameSafe(pool.Key),
+			pool.Value.Stats.InUse, pool.Value.Free.Num(), pool.Value.Stats.HighWater, pool.Value.Stats.Spawned, pool.Value.Stats.Reused);
+	}
+}
@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+
+/*
+* Keeps actors that are no longer needed in the world, hidden, so they can be handed out again instead of spawning new ones.
+* Actors are pooled by exact class. Released actors are hidden & lose collision & ticking; acquiring one moves it & restores those.
+* Anything specific to the actors' class must be reset by whoever releases it.
+*/
+class DAMNATION_API FDungeonActorPool
+{
+public:
+	struct FStats
+	{
+		int32 Spawned = 0;
+		int32 Reused = 0;
+		int32 InUse = 0;
+		// The most actors of the class in use at once
+		int32 HighWater = 0;
+		int32 Free = 0;
+	};
+
+	// Takes a free actor of exactly type, or spawns a new one if there's none. Returns nullptr if spawning fails.
+	AActor* Acquire(UWorld* world, UClass* type, const FTransform& transform);
+
+	template <class T>
+	T* Acquire(UWorld* world, UClass* type, const FTransform& transform) { return Cast<T>(Acquire(world, type, transform)); }
+
+	// Hides actor & keeps it for reuse.
+	void Release(AActor* actor);
+
+	// Destroys every free actor. Stats are kept.
+	void Empty();
+
+	FStats GetStats(UClass* type) const;
+
+	// Logs the stats of every class that has been pooled.
+	void LogStats() const;
+
+private:
+	struct FClassPool
+	{
+		// Weak as the level may destroy them first
+		TArray<TWeakObjectPtr<AActor>> Free;
+		FStats Stats;
+	};
+
+	TMap<UClass*, FClassPool> Pools;
+};
@@ -0,0 +1,108 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DungeonAsyncPathfinding.h"
+#include "DungeonJumpPointSearch.h"
+#include "Async/Async.h"
+
+void FDungeonAsyncPathRequest::GetPathTiles(TArray<ADungeonSingleTile*>& outPath) const
+{
+	if (Snapshot)
+		Snapshot->ToTiles(Path, outPath);
+	else
+		outPath.Reset();
+}
+
+FDungeonAsyncPathfinder::FDungeonAsyncPathfinder()
+	: Contexts(MakeShared<FDungeonPathContextPool, ESPMode::ThreadSafe>())
+{
+}
+
+FDungeonAsyncPathfinder::~FDungeonAsyncPathfinder()
+{
+	// Workers still running keep the contexts & snapshot alive through their own references
+	CancelAll();
+}
+
+FDungeonAsyncPathHandle FDungeonAsyncPathfinder::Request(const FDungeonTileGraph& graph, const FDungeonPathQuery& query, FOnComplete onComplete)
+{
+	check(IsInGameThread());
+	PrunePending();
+
+	// Take a new copy only if the graph has changed since the last one
+	if (!Snapshot || SnapshotTopologyVersion != graph.GetTopologyVersion() || SnapshotOccupancyVersion != graph.GetOccupancyVersion())
+	{
+		Snapshot = MakeShared<const FDungeonTileGraph, ESPMode::ThreadSafe>(graph);
+		SnapshotTopologyVersion = graph.GetTopologyVersion();
+		SnapshotOccupancyVersion = graph.GetOccupancyVersion();
+	}
+
+	FDungeonAsyncPathHandle request = MakeShared<FDungeonAsyncPathRequest, ESPMode::ThreadSafe>();
+	request->Id = NextId++;
+	request->Query = query;
+	request->Snapshot = Snapshot;
+	request->bAwaitingCallback = (bool)onComplete;
+	Pending.Add(request);
+
+	TSharedPtr<FDungeonPathContextPool, ESPMode::ThreadSafe> contexts = Contexts;
+	AsyncTask(ENamedThreads::AnyBackgroundThreadNormalTask, [request, contexts, onComplete]()
+	{
+		if (!request->IsCancelled())
+		{
+			FDungeonScopedPathContext context(*contexts);
+			const FDungeonTileGraph& graph = *request->Snapshot;
+			const FDungeonPathQuery& query = request->Query;
+			// Same order as GeneratePath, minus the room graph
+			if (!query.bRespectOccupants)
+				request->bSuccess = FDungeonJumpPointSearch::FindPath(graph, context.Get(), query, request->Path);
+			if (!request->bSuccess && (query.bRespectOccupants || query.bGetClosest))
+				request->bSuccess = FDungeonPathfinder::FindPath(graph, context.Get(), query, request->Path);
+		}
+		// Result must be written before this is set, pollers read it as soon as they see it
+		request->bComplete = true;
+
+		if (onComplete)
+		{
+			AsyncTask(ENamedThreads::GameThread, [request, onComplete]()
+			{
+				request->bAwaitingCallback = false;
+				// Checked again here as the request may have been cancelled while it was searching
+				if (!request->IsCancelled())
+					onComplete(*request);
+			});
+		}
+	});
+	return request;
+}
+
+bool FDungeonAsyncPathfinder::Cancel(int32 id)
+{
+	for (const FDungeonAsyncPathHandle& request : Pending)
+	{
+		if (request->GetId() == id)
+		{
+			request->Cancel();
+			PrunePending();
+			return true;
+		}
+	}
+	return false;
+}
+
+void FDungeonAsyncPathfinder::CancelAll()
+{
+	for (const FDungeonAsyncPathHandle& request : Pending)
+		request->Cancel();
+	Pending.Reset();
+	Snapshot.Reset();
+}
+
+int32 FDungeonAsyncPathfinder::GetPendingCount()
+{
+	PrunePending();
+	return Pending.Num();
+}
+
+void FDungeonAsyncPathfinder::PrunePending()
+{
+	Pending.RemoveAllSwap([](const FDungeonAsyncPathHandle& request) { return request->IsCancelled() || (request->IsComplete() && !request->bAwaitingCallback); });
+}
@@ -0,0 +1,95 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/ThreadSafeBool.h"
+#include "DungeonPathfinding.h"
+
+class ADungeonSingleTile;
+
+typedef TSharedPtr<const FDungeonTileGraph, ESPMode::ThreadSafe> FDungeonTileGraphSnapshot;
+
+/*
+* A single pathfinding query running on a worker thread.
+* The result is written once by the worker before the request is flagged complete, so it may be polled from the game thread
+* with IsComplete & then read freely.
+*/
+class DAMNATION_API FDungeonAsyncPathRequest
+{
+public:
+	int32 GetId() const { return Id; }
+	const FDungeonPathQuery& GetQuery() const { return Query; }
+
+	bool IsComplete() const { return bComplete; }
+	bool IsCancelled() const { return bCancelled; }
+
+	// Stops the request from being searched if it hasn't started yet & its completion callback from being called.
+	void Cancel() { bCancelled = true; }
+
+	// Only valid once complete.
+	bool WasSuccessful() const { return bSuccess; }
+
+	// Tile indices from the tile after the start up to & including the target, in the snapshot the search ran against.
+	const TArray<int32>& GetPath() const { return Path; }
+
+	// Converts the path to tile actors. Only call on the game thread, before the floor the request was made on is destroyed.
+	void GetPathTiles(TArray<ADungeonSingleTile*>& outPath) const;
+
+private:
+	friend class FDungeonAsyncPathfinder;
+
+	int32 Id = INDEX_NONE;
+	FDungeonPathQuery Query;
+	FDungeonTileGraphSnapshot Snapshot;
+
+	TArray<int32> Path;
+	bool bSuccess = false;
+	// Set while the completion callback is still to be called on the game thread, which can still cancel it until then
+	bool bAwaitingCallback = false;
+	FThreadSafeBool bComplete = false;
+	FThreadSafeBool bCancelled = false;
+};
+
+typedef TSharedPtr<FDungeonAsyncPathRequest, ESPMode::ThreadSafe> FDungeonAsyncPathHandle;
+
+/*
+* Runs FDungeonPathfinder queries on task graph worker threads.
+* Searches read an immutable copy of the tile graph, taken on the game thread when the request is made. The copy is shared by
+* every request made until the graph's topology or occupancy next changes, so a turn's worth of requests costs one copy.
+* Completion callbacks are called on the game thread, & never for cancelled requests.
+* Room-level routing isn't used, as the room graph is rebuilt on the game thread.
+* Unweighted queries use jump point search, falling back to A* like GeneratePath.
+*/
+class DAMNATION_API FDungeonAsyncPathfinder
+{
+public:
+	typedef TFunction<void(const FDungeonAsyncPathRequest&)> FOnComplete;
+
+	FDungeonAsyncPathfinder();
+	~FDungeonAsyncPathfinder();
+
+	// Queues a query against the current state of graph. Must be called on the game thread.
+	FDungeonAsyncPathHandle Request(const FDungeonTileGraph& graph, const FDungeonPathQuery& query, FOnComplete onComplete = nullptr);
+
+	// Cancels a pending request by id. Returns false if it wasn't pending.
+	bool Cancel(int32 id);
+
+	// Cancels every pending request & drops the snapshot. Call whenever the graph is reset.
+	void CancelAll();
+
+	int32 GetPendingCount();
+
+private:
+	// Removes delivered & cancelled requests from the pending list.
+	void PrunePending();
+
+	TSharedPtr<FDungeonPathContextPool, ESPMode::ThreadSafe> Contexts;
+
+	FDungeonTileGraphSnapshot Snapshot;
+	uint32 SnapshotTopologyVersion = 0;
+	uint32 SnapshotOccupancyVersion = 0;
+
+	TArray<FDungeonAsyncPathHandle> Pending;
+	int32 NextId = 0;
+};
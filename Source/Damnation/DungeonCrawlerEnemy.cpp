@@ -8,7 +8,6 @@
 ADungeonCrawlerEnemy::ADungeonCrawlerEnemy()
 {
 	Type = EOccupantType::Enemy;
-	RepathInterval = FMath::RandRange(0, MaxRepathInterval);
 
 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
@@ -31,11 +30,36 @@ void ADungeonCrawlerEnemy::PerformMovement()
 	// Will be properly set later if necessary
 	OldTransform = GetActorTransform();
 
-	ReceiveMoveAction();
+	{
+		DUNGEON_SCOPE_CYCLE_COUNTER(STAT_DungeonEnemyMoveAction);
+		ReceiveMoveAction();
+	}
+	// Move Action may have started an action without moving
+	if (TimeUntilActionPermitted > 0.0f)
+		WakeInterpolation();
+}
+
+int32 ADungeonCrawlerEnemy::GetPathStep() const
+{
+	return DesiredPath.Num() > 0 && DesiredPath[0] ? DesiredPath[0]->TileIndex : INDEX_NONE;
+}
+
+void ADungeonCrawlerEnemy::CommitMove(ADungeonSingleTile* tile, ECardinal direction)
+{
+	OldTransform = GetActorTransform();
+	SetModelFacing(direction);
+	// The flow field step may not be on the path, in which case the path is left for the next repath
+	if (DesiredPath.Num() > 0 && DesiredPath[0] == tile)
+		DesiredPath.RemoveAt(0);
+	SetTile(tile);
+	TimeUntilActionPermitted = ActionTime;
 }
 
 void ADungeonCrawlerEnemy::SetTarget(ADungeonSingleTile* Target)
 {
+	// Chasing the player reads the shared flow field rather than running a search per enemy
+	if (Target && Gamemode->ActivePlayer && Target == Gamemode->ActivePlayer->CurrentTile && Gamemode->GetFlowFieldPath(CurrentTile, DesiredPath))
+		return;
 	DesiredPath = Gamemode->CallPathfinder(CurrentTile, Target, 1, true, true);
 }
 
@@ -47,13 +71,18 @@ void ADungeonCrawlerEnemy::SetModelFacing(ECardinal direction)
 }
 
 void ADungeonCrawlerEnemy::AlertTarget(ADungeonSingleTile* Target)
+{
+	if (NeedsRepath(Target))
+		SetTarget(Target);
+}
+
+bool ADungeonCrawlerEnemy::NeedsRepath(ADungeonSingleTile* Target)
 {
 	// Post-Decrement repath interval; if <= 0, repath
 	if (RepathInterval-- <= 0 || DesiredPath.Num() == 0)
 	{
 		RepathInterval = MaxRepathInterval;
-		SetTarget(Target);
-		return;
+		return true;
 	}
 
 	// Get current target
@@ -68,11 +97,9 @@ void ADungeonCrawlerEnemy::AlertTarget(ADungeonSingleTile* Target)
 		}
 	// Target is outside potential range, repath
 	if (!next)
-	{
-		SetTarget(Target);
-		return;
-	}
+		return true;
 	DesiredPath.Add(next);
+	return false;
 }
 
 void ADungeonCrawlerEnemy::AlterHealth(int amount)
@@ -81,7 +108,7 @@ void ADungeonCrawlerEnemy::AlterHealth(int amount)
 	if (Health == 0)
 	{
 		if (CurrentTile)
-			CurrentTile->OccupyingActor = nullptr;
+			CurrentTile->SetOccupyingActor(nullptr);
 		ReceiveOnDeath();
 	}
 	else
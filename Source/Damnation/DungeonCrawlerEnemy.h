@@ -3,6 +3,7 @@
 #pragma once
 
 #include "DungeonTileOccupant.h"
+#include "DungeonTurnResolver.h"
 #include "DungeonCrawlerEnemy.generated.h"
 
 class ADungeonCrawlerPlayer;
@@ -22,6 +23,10 @@ public:
 	UFUNCTION(BlueprintImplementableEvent, meta = (DisplayName = "Move Action"))
 	void ReceiveMoveAction();
 
+	// Native enemies only, called once every native enemy has moved. target is the tile moved to, attacked or blocked by.
+	UFUNCTION(BlueprintImplementableEvent, meta = (DisplayName = "Turn Resolved"))
+	void ReceiveTurnResolved(EEnemyTurnAction action, ADungeonSingleTile* target);
+
 	UFUNCTION(BlueprintImplementableEvent, meta = (DisplayName = "Take Damage"))
 	void ReceiveTakeDamage();
 
@@ -56,6 +61,25 @@ public:
 	UPROPERTY(BlueprintReadWrite)
 	class ADungeonRoomTileBase* OriginRoom;
 
+	// Whether the game mode decides & makes this enemies' moves, rather than its Move Action event.
+	bool UsesNativeMovement() const { return bNativeMovement; }
+
+	// The tile index of the next tile on this enemies' path, INDEX_NONE if it has none.
+	int32 GetPathStep() const;
+
+	// Keeps the path toward Target without searching where it can, as AlertTarget does. Returns true if a new path is needed,
+	// so the game mode can search for it with the other native enemies' turns.
+	bool NeedsRepath(ADungeonSingleTile* Target);
+
+	// Replaces the path with one found by the game mode, [0] being the next desired tile.
+	void SetDesiredPath(const TArray<ADungeonSingleTile*>& path) { DesiredPath = path; }
+
+	// Moves onto tile, in direction from the current tile. Used by the game mode to apply a native enemies' move.
+	void CommitMove(ADungeonSingleTile* tile, ECardinal direction);
+
+	// Staggers the first forced repath, so enemies spawned together don't all repath on the same turn.
+	void SeedRepathInterval(FRandomStream& stream) { RepathInterval = stream.RandRange(0, MaxRepathInterval); }
+
 protected:
 	// The time between forced repath executions
 	UPROPERTY(EditDefaultsOnly)
@@ -68,6 +92,11 @@ protected:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly)
 	int Health = 1;
 
+	// If set, the game mode moves this enemy toward the player alongside the other native enemies, & Move Action isn't called.
+	// Their moves are decided in parallel, so turn it off for enemies that do more than chase; Turn Resolved is called with the outcome.
+	UPROPERTY(EditDefaultsOnly)
+	bool bNativeMovement = true;
+
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
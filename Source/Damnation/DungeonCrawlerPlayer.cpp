@@ -37,10 +37,8 @@ void ADungeonCrawlerPlayer::DoAction(ECardinal cardinal)
 {
 	if (!CanMove())
 		return;
-	// enum to int for array access purposes
-	uint8 iCardinal = (uint8)cardinal;
 	// Ensure we're on a tile & that tile has another accessible tile in the direction specified
-	if (!(CurrentTile && CurrentTile->CardinalConnections[iCardinal]))
+	if (!(CurrentTile && CurrentTile->GetAdjacent(cardinal)))
 		return;
 
 	// Update oldpos to match current pos so lagged root doesn't wig out
@@ -48,7 +46,7 @@ void ADungeonCrawlerPlayer::DoAction(ECardinal cardinal)
 	OldPosition = GetActorLocation();
 
 	// Get the next tile
-	ADungeonSingleTile* nextTile = CurrentTile->CardinalConnections[iCardinal];
+	ADungeonSingleTile* nextTile = CurrentTile->GetAdjacent(cardinal);
 
 	// Get latest action in buffer
 	EPlayerAction nextAction = ActionBuffer.Last();
@@ -114,8 +112,8 @@ void ADungeonCrawlerPlayer::JumpToTile(ADungeonSingleTile* nextTile, ECardinal m
 	OldPosition = GetActorLocation();
 	SetActorLocation(nextTile->GetActorLocation(), false, nullptr, ETeleportType::TeleportPhysics);
 	LaggedRoot->SetWorldLocation(OldPosition);
-	CurrentTile->OccupyingActor = nullptr;
-	nextTile->OccupyingActor = this;
+	CurrentTile->SetOccupyingActor(nullptr);
+	nextTile->SetOccupyingActor(this);
 	CurrentTile = nextTile;
 	ReceiveOnMove(OldPosition, GetActorLocation(), moveDir);
 	nextTile->TileEvent.Broadcast(this, nextTile);
@@ -131,6 +129,9 @@ void ADungeonCrawlerPlayer::Tick(float DeltaTime)
 	if (MovementBuffer.Last() != ECardinal::NULLDIR)
 		DoAction(MovementBuffer.Last());
 
+	// Input is read every frame, but the lagged root only needs moving until it has caught up
+	if (TimeUntilActionPermitted <= 0.0f && ActionTimeScalar <= 0.0f)
+		return;
 	TimeUntilActionPermitted = FMath::Max(TimeUntilActionPermitted - DeltaTime, 0.0f);
 	ActionTimeScalar = TimeUntilActionPermitted / ActionTime;
 
@@ -166,7 +167,7 @@ void ADungeonCrawlerPlayer::AlterHealth(int val)
 	if (Health <= 0)
 	{
 		// Death functionality here
-		CurrentTile->OccupyingActor = nullptr;
+		CurrentTile->SetOccupyingActor(nullptr);
 		ReceiveOnDeath();
 	}
 }
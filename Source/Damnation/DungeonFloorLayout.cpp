@@ -0,0 +1,190 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DungeonFloorLayout.h"
+#include "DungeonRoomTileBase.h"
+
+namespace
+{
+	// Jump table for positions
+	const FVector2D jumpDirTable[4] =
+	{
+		FVector2D(1, 0),
+		FVector2D(0, 1),
+		FVector2D(-1, 0),
+		FVector2D(0, -1)
+	};
+	// Typedefs for ease of reading
+	// TConPair == direction & room position, representing a connector
+	// TConPairChance == TConPair + float, is TConPair with chance representing potential to spawn a new room there
+	typedef TPair<int, FVector2D> TConPair;
+	typedef TPair<TConPair, float> TConPairChance;
+}
+
+void FDungeonFloorLayoutSettings::BuildRoomClasses(const TArray<TSubclassOf<ADungeonRoomTileBase>>& roomList)
+{
+	RoomClasses.Build(roomList);
+
+	Connectors.Reset();
+	for (const TSubclassOf<ADungeonRoomTileBase>& room : roomList)
+		if (room)
+			Connectors.Add(room, FDungeonRoomClassIndex::MakeMask(room.GetDefaultObject()->ValidCardinals));
+	for (const TSubclassOf<ADungeonRoomTileBase>& room : { StarterRoom, TutorialRoom, MuralRoom, EscapeRoom })
+		if (room)
+			Connectors.Add(room, FDungeonRoomClassIndex::MakeMask(room.GetDefaultObject()->ValidCardinals));
+}
+
+void FDungeonFloorLayoutSolver::Begin(const FDungeonFloorLayoutSettings& settings, int32 seed)
+{
+	Settings = settings;
+	Stream.Initialize(seed);
+	FillChance = Settings.MaxFillChance;
+	Plan.Init(nullptr, Settings.Width * Settings.Height);
+	Order.Reset();
+	OpenConnectors.Reset();
+
+	const uint8 allConnectors = FDungeonRoomClassIndex::MaskCount - 1;
+
+	PlanRoom(Settings.StarterRoomPosition, Settings.StarterRoom);
+	PlanRoom(Settings.StarterRoomPosition + FVector2D(1, 0), Settings.TutorialRoom);
+	FVector2D MuralRoomPosition = Settings.EscapeRoomPosition - FVector2D(1, 0);
+	PlanRoom(Settings.EscapeRoomPosition, Settings.EscapeRoom);
+	PlanRoom(MuralRoomPosition, Settings.MuralRoom);
+
+	// Connectors to starting split & mural
+	for (int i = 0; i < 3; ++i)
+	{
+		OpenConnectors.Add(TConPair((i + 1) % 4, MuralRoomPosition));
+	}
+
+	// Do Bresenham's Line Algorithm to make guaranteed path between start & end positions
+	{
+		int x0 = Settings.StarterRoomPosition.X;
+		int y0 = Settings.StarterRoomPosition.Y;
+		int x1 = MuralRoomPosition.X;
+		int y1 = MuralRoomPosition.Y;
+
+		int mNew = 2 * (y1 - y0);
+		int slopeError = mNew - (x1 - x0);
+
+		for (int x = x0, y = y0; x <= x1; ++x)
+		{
+			// Ensure room used is likely to be unique, only 4-way rooms are used
+			auto roomType = Settings.RoomClasses.PickLeastUsed(allConnectors, Stream);
+			// Add the room to the position
+			FVector2D bresPos = FVector2D(x, y);
+			if (PlanRoom(bresPos, roomType).Get() != Settings.StarterRoom.Get())
+				for (int i = 0; i < 4; ++i) OpenConnectors.Add(TConPair((i + 3) % 4, bresPos));
+
+			// Algorithm-relevant
+			slopeError += mNew;
+			if (slopeError >= 0)
+			{
+				++y;
+				slopeError -= 2 * (x1 - x0);
+			}
+		}
+	}
+}
+
+bool FDungeonFloorLayoutSolver::Step()
+{
+	if (OpenConnectors.Num() == 0)
+		return false;
+
+	int idx = Stream.RandRange(0, OpenConnectors.Num() - 1);
+	TConPair connector = OpenConnectors[idx];
+	FVector2D start = connector.Value;
+	FVector2D current = jumpDirTable[connector.Key] + connector.Value;
+	if (!IsValidSpace(current))
+	{
+		UE_LOG(LogTemp, Error, TEXT("Connector leading to outside map boundaries; typically the result of the map being smaller than the mural/escape/start room positions. Increase map size or move the offending room."))
+	}
+	else if (!GetRoom(current))
+	{
+		// Tpair: Holds TConPair & float determining chance of connections in new room (0..1 range of probability)
+		TArray<TConPairChance, TFixedAllocator<4>> newConnectorChances;
+		// Check all adjacent rooms to the new room spot that aren't what we just came from
+		for (int i = 0; i < 4; ++i)
+		{
+			float chance;
+			FVector2D pos = jumpDirTable[i] + current;
+			// If it cannot support a tile, make it guaranteed failure
+			if (!IsValidSpace(pos)) chance = -1.0f;
+			// Original room must be connected, so ensure it with guaranteed chance
+			else if (pos == start) chance = 1.0f;
+			else
+			{
+				TSubclassOf<ADungeonRoomTileBase> nextRoom = GetRoom(pos);
+				if (nextRoom)
+				{
+					// If there is a connector in room to current, make it a guaranteed connector
+					// Else don't allow it to be a connector at all
+					const uint8* nextConnectors = Settings.Connectors.Find(nextRoom);
+					chance = nextConnectors && (*nextConnectors & (1 << ((i + 2) % 4))) ? 1.0f : -1.0f;
+				}
+				// If there's no existing room but can support a tile, make it a random chance of being a connector accounting for bias
+				else
+				{
+					int relativeDir = ((i - connector.Key) + 4) % 4;
+
+					chance = GetFill() * Settings.DirectionalBiases[relativeDir];
+				}
+			}
+			newConnectorChances.Add(TConPairChance(TConPair(i, current), chance));
+		}
+		// Take chance array and make decisions on necessary connectors
+		uint8 newConnectors = 0;
+		for (int i = 0; i < 4; ++i)
+		{
+			// Potential connection chance
+			if (newConnectorChances[i].Value >= Stream.FRand())
+				newConnectors |= 1 << i;
+		}
+		// Pick the least used room with exactly these connectors to place down, if any can be placed
+		if (Settings.RoomClasses.HasRoom(newConnectors))
+		{
+			PlanRoom(current, Settings.RoomClasses.PickLeastUsed(newConnectors, Stream));
+			// Add connectors of new room to list, except to previous room
+			for (int i = 0; i < 4; ++i)
+			{
+				if (jumpDirTable[i] + current == start)
+					continue;
+				if (newConnectors & (1 << i))
+					OpenConnectors.Add(TConPair(i, current));
+			}
+		}
+	}
+	// Remove the connector we just sorted out
+	OpenConnectors.RemoveAtSwap(idx, 1, false);
+	return true;
+}
+
+TSubclassOf<ADungeonRoomTileBase> FDungeonFloorLayoutSolver::GetRoom(FVector2D position) const
+{
+	return IsValidSpace(position) ? Plan[GridToFlatIndex(position)] : nullptr;
+}
+
+bool FDungeonFloorLayoutSolver::IsValidSpace(FVector2D position) const
+{
+	return !((int)position.X >= Settings.Height || (int)position.Y >= Settings.Width || position.X < 0 || position.Y < 0);
+}
+
+TSubclassOf<ADungeonRoomTileBase> FDungeonFloorLayoutSolver::PlanRoom(FVector2D position, TSubclassOf<ADungeonRoomTileBase> roomType)
+{
+	if (!IsValidSpace(position))
+		return nullptr;
+	int32 index = GridToFlatIndex(position);
+	if (!Plan[index] && roomType)
+	{
+		Plan[index] = roomType;
+		Order.Add(position);
+	}
+	return Plan[index];
+}
+
+float FDungeonFloorLayoutSolver::GetFill()
+{
+	float cFill = FillChance;
+	FillChance = FMath::Max(FillChance - Settings.FillChanceVelocity, Settings.MinFillChance);
+	return cFill;
+}
@@ -0,0 +1,94 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Math/RandomStream.h"
+#include "DungeonRoomClassIndex.h"
+
+class ADungeonRoomTileBase;
+
+// Everything the layout solver needs from a macro grid. Filled on the game thread, so solving never reads a UObject.
+struct DAMNATION_API FDungeonFloorLayoutSettings
+{
+	// Grid bounds; X runs up to Height & Y up to Width, the same as ADungeonMacroGrid::IsValidSpace
+	int32 Width = 0;
+	int32 Height = 0;
+
+	FVector2D StarterRoomPosition;
+	FVector2D EscapeRoomPosition;
+
+	TSubclassOf<ADungeonRoomTileBase> StarterRoom;
+	TSubclassOf<ADungeonRoomTileBase> TutorialRoom;
+	TSubclassOf<ADungeonRoomTileBase> MuralRoom;
+	TSubclassOf<ADungeonRoomTileBase> EscapeRoom;
+
+	float MinFillChance = 0.1f;
+	float MaxFillChance = 1.0f;
+	float FillChanceVelocity = 0.1f;
+	float DirectionalBiases[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+	// The room list grouped by connectors
+	FDungeonRoomClassIndex RoomClasses;
+
+	// Connector mask of every class that can be placed, see FDungeonRoomClassIndex::MakeMask
+	TMap<UClass*, uint8> Connectors;
+
+	// Fills the room classes & their connectors from the fixed rooms & roomList. Game thread only.
+	void BuildRoomClasses(const TArray<TSubclassOf<ADungeonRoomTileBase>>& roomList);
+};
+
+/*
+* Decides which room class goes in each cell of a floor, without spawning anything.
+* Rooms are decided in the same way as the macro grid always has: the fixed rooms, a guaranteed path of 4-way rooms between the
+* starter & mural rooms, then open connectors extended at random until none are left. All randomness comes from a stream seeded
+* in Begin, so a layout can be solved on any thread & the same seed always gives the same layout.
+*/
+class DAMNATION_API FDungeonFloorLayoutSolver
+{
+public:
+	// Starts a new layout, deciding the fixed rooms & the guaranteed path between them.
+	void Begin(const FDungeonFloorLayoutSettings& settings, int32 seed);
+
+	// Extends one open connector. Returns false once there are none left & the layout is complete.
+	bool Step();
+
+	// Steps until the layout is complete.
+	void Solve() { while (Step()); }
+
+	bool IsStarted() const { return Plan.Num() > 0; }
+	bool IsComplete() const { return IsStarted() && OpenConnectors.Num() == 0; }
+
+	// The class planned at position, nullptr if there's none or position is out of bounds.
+	TSubclassOf<ADungeonRoomTileBase> GetRoom(FVector2D position) const;
+
+	// Positions of the planned rooms, in the order they were decided.
+	const TArray<FVector2D>& GetOrder() const { return Order; }
+
+	int32 GetOpenConnectorCount() const { return OpenConnectors.Num(); }
+
+	// The fill chance after decaying, carried over to the next floor.
+	float GetFillChance() const { return FillChance; }
+
+	int32 GetSeed() const { return Stream.GetInitialSeed(); }
+
+	bool IsValidSpace(FVector2D position) const;
+
+private:
+	int32 GridToFlatIndex(FVector2D position) const { return (int32)position.Y * Settings.Height + (int32)position.X; }
+
+	// Plans a room at position if there isn't one. Returns the class planned there, nullptr if none or out of bounds.
+	TSubclassOf<ADungeonRoomTileBase> PlanRoom(FVector2D position, TSubclassOf<ADungeonRoomTileBase> roomType);
+
+	// Get fill chance & modify by velocity
+	float GetFill();
+
+	FDungeonFloorLayoutSettings Settings;
+	FRandomStream Stream;
+	float FillChance = 1.0f;
+
+	TArray<TSubclassOf<ADungeonRoomTileBase>> Plan;
+	TArray<FVector2D> Order;
+	// Direction & room position of connectors yet to be extended
+	TArray<TPair<int, FVector2D>> OpenConnectors;
+};
@@ -0,0 +1,100 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DungeonFlowField.h"
+
+bool FDungeonFlowField::Update(const FDungeonTileGraph& graph, int32 goal, float radius, uint32 ignoredOccupant)
+{
+	if (bValid && Goal == goal && Radius == radius && IgnoredOccupant == ignoredOccupant &&
+		TopologyVersion == graph.GetTopologyVersion())
+		return false;
+
+	Goal = goal;
+	Radius = radius;
+	IgnoredOccupant = ignoredOccupant;
+	TopologyVersion = graph.GetTopologyVersion();
+	ReachedCount = 0;
+	bValid = graph.IsValidTile(goal);
+	if (!bValid)
+		return true;
+
+	Context.Begin(graph.Num());
+	Context.Push(goal);
+
+	while (Context.OpenNum() > 0)
+	{
+		int32 current = Context.Pop();
+		FDungeonPathNode& currentNode = Context.GetNode(current);
+		currentNode.bClosed = true;
+		++ReachedCount;
+
+		float cost = currentNode.gCost + 1.0f;
+		if (cost > radius)
+			continue;
+
+		for (int32 dir = 0; dir < FDungeonTileGraph::CardinalCount; ++dir)
+		{
+			int32 connection = graph.GetNeighbour(current, dir);
+			if (connection == INDEX_NONE || Context.IsClosed(connection) || graph.GetAvailableSpace(connection) < 1 || graph.IsPathingIgnored(connection))
+				continue;
+			// Only flow back along links the pather could actually walk
+			bool bLinked = false;
+			for (int32 back = 0; back < FDungeonTileGraph::CardinalCount; ++back)
+				bLinked |= graph.GetNeighbour(connection, back) == current;
+			if (!bLinked)
+				continue;
+
+			bool bInOpenList = Context.IsOpen(connection);
+			FDungeonPathNode& connectionNode = Context.GetNode(connection);
+			if (bInOpenList && cost >= connectionNode.gCost)
+				continue;
+			connectionNode.gCost = cost;
+			connectionNode.Parent = current;
+			if (bInOpenList)
+				Context.Update(connection);
+			else
+				Context.Push(connection);
+		}
+	}
+	return true;
+}
+
+int32 FDungeonFlowField::GetNextStep(int32 tile) const
+{
+	if (!bValid)
+		return INDEX_NONE;
+	const FDungeonPathNode* node = Context.FindNode(tile);
+	return node && node->bClosed ? node->Parent : INDEX_NONE;
+}
+
+int32 FDungeonFlowField::GetNextStep(const FDungeonTileGraph& graph, int32 tile) const
+{
+	auto isBlocked = [&](int32 step)
+	{
+		uint32 occupant = graph.GetOccupant(step);
+		return step != Goal && occupant != 0 && occupant != IgnoredOccupant;
+	};
+
+	int32 next = GetNextStep(tile);
+	if (next == INDEX_NONE || !isBlocked(next))
+		return next;
+	// Any neighbour cheaper than tile is on a shortest route too
+	const float cost = GetCost(tile);
+	for (int32 dir = 0; dir < FDungeonTileGraph::CardinalCount; ++dir)
+	{
+		int32 connection = graph.GetNeighbour(tile, dir);
+		if (connection == INDEX_NONE || connection == next)
+			continue;
+		float connectionCost = GetCost(connection);
+		if (connectionCost >= 0.0f && connectionCost < cost && !isBlocked(connection))
+			return connection;
+	}
+	return next;
+}
+
+float FDungeonFlowField::GetCost(int32 tile) const
+{
+	if (!bValid)
+		return -1.0f;
+	const FDungeonPathNode* node = Context.FindNode(tile);
+	return node && node->bClosed ? node->gCost : -1.0f;
+}
@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DungeonPathfinding.h"
+
+/*
+* Dijkstra distance field flowing toward a single goal tile, shared by every 1x1 pather chasing that goal.
+* The search is bounded by a radius & only reruns when the goal or the floor changes, so any number of pathers can read
+* their next step in O(1) for the cost of at most one search per turn. Occupants don't affect the field;
+* they're checked as each step is read, so enemies moving during a turn don't force a rebuild.
+* Each rerun is a full rebuild of the tiles within the radius, not a repair. Chasing the player moves the goal every
+* player step, and moving the goal a tile changes the cost of every tile in the field by one, so there's nothing to reuse.
+* Node records live in a search context, so a rebuild only touches the tiles within the radius.
+*/
+class DAMNATION_API FDungeonFlowField
+{
+public:
+	/*
+	* Rebuilds the field toward goal if anything it depends on has changed since the last build.
+	* radius is the furthest cost from the goal to expand to, ignoredOccupant is never treated as blocking a step (typically the player).
+	* Returns true if the field was rebuilt.
+	*/
+	bool Update(const FDungeonTileGraph& graph, int32 goal, float radius, uint32 ignoredOccupant);
+
+	// Forces the next update to rebuild.
+	void Invalidate() { bValid = false; }
+
+	int32 GetGoal() const { return bValid ? Goal : INDEX_NONE; }
+
+	// The next tile toward the goal from tile, INDEX_NONE if tile is the goal or outside the field.
+	int32 GetNextStep(int32 tile) const;
+
+	// Same as GetNextStep, but if that tile is occupied takes another step just as close to the goal that isn't, where there is one.
+	int32 GetNextStep(const FDungeonTileGraph& graph, int32 tile) const;
+
+	// Cost to reach the goal from tile, negative if tile is outside the field.
+	float GetCost(int32 tile) const;
+
+	// Number of tiles reached by the last build.
+	int32 GetReachedCount() const { return ReachedCount; }
+
+private:
+	FDungeonPathContext Context;
+	int32 Goal = INDEX_NONE;
+	float Radius = 0.0f;
+	uint32 IgnoredOccupant = 0;
+	uint32 TopologyVersion = 0;
+	int32 ReachedCount = 0;
+	bool bValid = false;
+};
@@ -16,6 +16,7 @@ public:
 	SLATE_ARGUMENT(UTexture2D*, LoadingBG)
 	SLATE_ARGUMENT(float, LoadingImageEdgeSize)
 	SLATE_ARGUMENT(float, LoadingSymbolRotateTime)
+	SLATE_ATTRIBUTE(TOptional<float>, Progress)
 	SLATE_END_ARGS()
 
 		void Construct(const FArguments& InArgs)
@@ -31,6 +32,7 @@ public:
 		LoadingBG.DrawAs = ESlateBrushDrawType::Image;
 
 		RotationSpeed = InArgs._LoadingSymbolRotateTime;
+		Progress = InArgs._Progress;
 
 		// SWidget::RegisterActiveTimer(0, FWidgetActiveTimerDelegate::CreateSP(this, &SDungeonLoadingScreenWidget::LoadRotatorTick));
 		ChildSlot
@@ -46,6 +48,15 @@ public:
 					.Image(&LoadingBrush)
 					.Period(RotationSpeed)
 				]
+			+ SConstraintCanvas::Slot()
+				.Anchors(FAnchors(0, 1, 1, 1))
+				.Offset(FMargin(0, -24, 0, 8))
+				.ZOrder(1)
+				[
+					SNew(SProgressBar)
+					.Percent(Progress)
+					.Visibility(this, &SDungeonLoadingScreenWidget::GetProgressVisibility)
+				]
 			+ SConstraintCanvas::Slot()
 				.Anchors(FAnchors(0, 0, 1, 1))
 				.ZOrder(0)
@@ -64,7 +75,14 @@ protected:
 	float CurrentRotation = 0.0f;
 	float RotationSpeed = 1.0f;
 
+	TAttribute<TOptional<float>> Progress;
+
 private:
+	EVisibility GetProgressVisibility() const
+	{
+		return Progress.Get().IsSet() ? EVisibility::Visible : EVisibility::Collapsed;
+	}
+
 	EVisibility GetLoadIndicatorVisibility() const
 	{
 		return GetMoviePlayer()->IsLoadingFinished() ? EVisibility::Collapsed : EVisibility::Visible;
@@ -103,7 +121,8 @@ void UDungeonGameInstanceBase::BeginLoadingScreen(const FString& InMapName)
 			.LoadingRotator(LoadingScreenImage)
 			.LoadingImageEdgeSize(128)
 			.LoadingSymbolRotateTime(LoadingScreenIconRotateSpeed)
-			.LoadingBG(LoadingScreenBackground);
+			.LoadingBG(LoadingScreenBackground)
+			.Progress(TAttribute<TOptional<float>>::Create(TAttribute<TOptional<float>>::FGetter::CreateUObject(this, &UDungeonGameInstanceBase::GetLoadingProgress)));
 
 		GetMoviePlayer()->SetupLoadingScreen(LoadingScreen);
 	}
@@ -113,3 +132,18 @@ void UDungeonGameInstanceBase::EndLoadingScreen(UWorld* InLoadedWorld)
 {
 
 }
+
+void UDungeonGameInstanceBase::SetGenerationProgress(float progress)
+{
+	if (GenerationProgress == progress)
+		return;
+	GenerationProgress = progress;
+	OnGenerationProgress(progress);
+}
+
+TOptional<float> UDungeonGameInstanceBase::GetLoadingProgress() const
+{
+	if (GenerationProgress <= 0.0f || GenerationProgress >= 1.0f)
+		return TOptional<float>();
+	return GenerationProgress;
+}
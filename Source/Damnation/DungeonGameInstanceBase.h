@@ -24,6 +24,17 @@ public:
 	UFUNCTION(BlueprintCallable)
 	virtual void EndLoadingScreen(UWorld* InLoadedWorld);
 
+	// Reports floor generation progress, 0..1, to the loading screen. Called by the macro grid while generating over multiple frames.
+	UFUNCTION(BlueprintCallable)
+	void SetGenerationProgress(float progress);
+
+	UFUNCTION(BlueprintPure)
+	float GetGenerationProgress() const { return GenerationProgress; }
+
+	// Called whenever the floor generation progress changes, for loading screens shown by Blueprint.
+	UFUNCTION(BlueprintImplementableEvent)
+	void OnGenerationProgress(float progress);
+
 	UPROPERTY(EditAnywhere)
 	UTexture2D* LoadingScreenImage;
 	UPROPERTY(EditAnywhere)
@@ -32,4 +43,10 @@ public:
 	float LoadingScreenIconRotateSpeed;
 	UPROPERTY(EditAnywhere)
 	float LoadingScreenIconEdgeSize;
+
+protected:
+	float GenerationProgress = 0.0f;
+
+	// Progress shown by the loading screen widget, unset while nothing is generating
+	TOptional<float> GetLoadingProgress() const;
 };
@@ -0,0 +1,250 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DungeonIncrementalPlanner.h"
+
+namespace
+{
+	const float Infinity = TNumericLimits<float>::Max();
+}
+
+bool FDungeonIncrementalPlanner::Plan(const FDungeonTileGraph& graph, int32 start, int32 goal, TArray<int32>& outPath)
+{
+	outPath.Reset();
+	LastExpansions = 0;
+	if (!graph.IsValidTile(start) || !graph.IsValidTile(goal) || start == goal)
+		return false;
+
+	TArray<int32> changes;
+	if (!bInitialized || GoalNode != graph.Num() || !graph.GetChangesSince(JournalPosition, changes))
+	{
+		Initialize(graph, start, goal);
+	}
+	else
+	{
+		// The pather moved, raise every key by how far so old keys stay valid lower bounds
+		if (start != Start)
+		{
+			KeyModifier += graph.EstimateSteps(Start, start);
+			Start = start;
+		}
+		// The target moved, move the virtual goals' edge
+		if (goal != Goal)
+		{
+			int32 oldGoal = Goal;
+			Goal = goal;
+			UpdateVertex(graph, oldGoal);
+			UpdateVertex(graph, goal);
+		}
+		// Tiles whose connections, space or pathing changed
+		for (int32 tile : changes)
+		{
+			UpdateLinks(graph, tile);
+			UpdateVertex(graph, tile);
+			UpdatePredecessors(graph, tile);
+		}
+	}
+	JournalPosition = graph.GetJournalEnd();
+
+	ComputeShortestPath(graph);
+	if (G[Start] == Infinity)
+		return false;
+
+	// Walk down the cost gradient to the target
+	int32 current = Start;
+	while (current != Goal && outPath.Num() < G.Num())
+	{
+		int32 best = INDEX_NONE;
+		float bestCost = Infinity;
+		for (int32 dir = 0; dir < FDungeonTileGraph::CardinalCount; ++dir)
+		{
+			int32 connection = graph.GetNeighbour(current, dir);
+			if (connection == INDEX_NONE || !CanEnter(graph, connection) || G[connection] == Infinity)
+				continue;
+			if (G[connection] + 1.0f < bestCost)
+			{
+				best = connection;
+				bestCost = G[connection] + 1.0f;
+			}
+		}
+		if (best == INDEX_NONE)
+		{
+			outPath.Reset();
+			return false;
+		}
+		outPath.Add(best);
+		current = best;
+	}
+	return current == Goal;
+}
+
+void FDungeonIncrementalPlanner::Initialize(const FDungeonTileGraph& graph, int32 start, int32 goal)
+{
+	GoalNode = graph.Num();
+	const int32 nodeCount = GoalNode + 1;
+	G.Init(Infinity, nodeCount);
+	Rhs.Init(Infinity, nodeCount);
+	Context.Begin(nodeCount);
+
+	Start = start;
+	Goal = goal;
+	KeyModifier = 0.0f;
+
+	Links.SetNumUninitialized(GoalNode * FDungeonTileGraph::CardinalCount);
+	OneWayPredecessors.Reset();
+	for (int32 tile = 0; tile < GoalNode; ++tile)
+	{
+		for (int32 dir = 0; dir < FDungeonTileGraph::CardinalCount; ++dir)
+		{
+			int32 connection = graph.GetNeighbour(tile, dir);
+			Links[tile * FDungeonTileGraph::CardinalCount + dir] = connection;
+			if (connection != INDEX_NONE && !LinksTo(graph, connection, tile))
+				OneWayPredecessors.AddUnique(connection, tile);
+		}
+	}
+
+	Rhs[GoalNode] = 0.0f;
+	OpenPush(graph, GoalNode);
+	bInitialized = true;
+}
+
+float FDungeonIncrementalPlanner::Heuristic(const FDungeonTileGraph& graph, int32 node) const
+{
+	int32 tile = node == GoalNode ? Goal : node;
+	return graph.EstimateSteps(Start, tile);
+}
+
+FDungeonIncrementalPlanner::FKey FDungeonIncrementalPlanner::CalculateKey(const FDungeonTileGraph& graph, int32 node) const
+{
+	float cost = FMath::Min(G[node], Rhs[node]);
+	if (cost == Infinity)
+		return { Infinity, Infinity };
+	// Summed in the same order as FDungeonPathNode::fCost so keys read back from the open list compare equal
+	return { Heuristic(graph, node) + KeyModifier + cost, cost };
+}
+
+bool FDungeonIncrementalPlanner::CanEnter(const FDungeonTileGraph& graph, int32 tile) const
+{
+	return graph.GetAvailableSpace(tile) >= ActorSize && !graph.IsPathingIgnored(tile);
+}
+
+bool FDungeonIncrementalPlanner::LinksTo(const FDungeonTileGraph& graph, int32 from, int32 to)
+{
+	for (int32 dir = 0; dir < FDungeonTileGraph::CardinalCount; ++dir)
+		if (graph.GetNeighbour(from, dir) == to)
+			return true;
+	return false;
+}
+
+void FDungeonIncrementalPlanner::UpdateLinks(const FDungeonTileGraph& graph, int32 tile)
+{
+	for (int32 dir = 0; dir < FDungeonTileGraph::CardinalCount; ++dir)
+	{
+		int32& link = Links[tile * FDungeonTileGraph::CardinalCount + dir];
+		int32 connection = graph.GetNeighbour(tile, dir);
+		if (connection == link)
+			continue;
+		// Either end may have gained or lost its reverse link
+		int32 old = link;
+		link = connection;
+		UpdateOneWayLinks(graph, tile, old);
+		UpdateOneWayLinks(graph, tile, connection);
+	}
+}
+
+void FDungeonIncrementalPlanner::UpdateOneWayLinks(const FDungeonTileGraph& graph, int32 a, int32 b)
+{
+	if (b == INDEX_NONE)
+		return;
+	OneWayPredecessors.Remove(a, b);
+	OneWayPredecessors.Remove(b, a);
+	bool bAToB = LinksTo(graph, a, b);
+	bool bBToA = LinksTo(graph, b, a);
+	if (bAToB && !bBToA)
+		OneWayPredecessors.AddUnique(b, a);
+	else if (bBToA && !bAToB)
+		OneWayPredecessors.AddUnique(a, b);
+}
+
+void FDungeonIncrementalPlanner::UpdateVertex(const FDungeonTileGraph& graph, int32 node)
+{
+	if (node != GoalNode)
+	{
+		// Cheapest way to the goal through any successor
+		float rhs = node == Goal ? G[GoalNode] : Infinity;
+		for (int32 dir = 0; dir < FDungeonTileGraph::CardinalCount; ++dir)
+		{
+			int32 connection = graph.GetNeighbour(node, dir);
+			if (connection != INDEX_NONE && G[connection] != Infinity && CanEnter(graph, connection))
+				rhs = FMath::Min(rhs, G[connection] + 1.0f);
+		}
+		Rhs[node] = rhs;
+	}
+
+	if (Context.IsOpen(node))
+		Context.Remove(node);
+	if (G[node] != Rhs[node])
+		OpenPush(graph, node);
+}
+
+void FDungeonIncrementalPlanner::UpdatePredecessors(const FDungeonTileGraph& graph, int32 node)
+{
+	if (node == GoalNode)
+	{
+		UpdateVertex(graph, Goal);
+		return;
+	}
+	for (int32 dir = 0; dir < FDungeonTileGraph::CardinalCount; ++dir)
+	{
+		// Tiles node links to that link back onto it
+		int32 connection = graph.GetNeighbour(node, dir);
+		if (connection != INDEX_NONE && LinksTo(graph, connection, node))
+			UpdateVertex(graph, connection);
+	}
+	// & tiles that link onto node without a link back
+	for (TMultiMap<int32, int32>::TConstKeyIterator it = OneWayPredecessors.CreateConstKeyIterator(node); it; ++it)
+		UpdateVertex(graph, it.Value());
+}
+
+void FDungeonIncrementalPlanner::ComputeShortestPath(const FDungeonTileGraph& graph)
+{
+	while (Context.OpenNum() > 0 && (GetOpenKey(Context.Peek()) < CalculateKey(graph, Start) || Rhs[Start] != G[Start]))
+	{
+		int32 node = Context.Peek();
+		FKey oldKey = GetOpenKey(node);
+		FKey newKey = CalculateKey(graph, node);
+		++LastExpansions;
+
+		if (oldKey < newKey)
+		{
+			// Key is out of date from the pather moving, requeue
+			Context.Remove(node);
+			OpenPush(graph, node);
+		}
+		else if (G[node] > Rhs[node])
+		{
+			G[node] = Rhs[node];
+			Context.Remove(node);
+			UpdatePredecessors(graph, node);
+		}
+		else
+		{
+			G[node] = Infinity;
+			UpdateVertex(graph, node);
+			UpdatePredecessors(graph, node);
+		}
+	}
+}
+
+void FDungeonIncrementalPlanner::OpenPush(const FDungeonTileGraph& graph, int32 node)
+{
+	FDungeonPathNode& record = Context.GetNode(node);
+	record.gCost = Heuristic(graph, node) + KeyModifier;
+	record.hCost = FMath::Min(G[node], Rhs[node]);
+	Context.Push(node);
+}
+
+FDungeonIncrementalPlanner::FKey FDungeonIncrementalPlanner::GetOpenKey(int32 node) const
+{
+	const FDungeonPathNode& record = *Context.FindNode(node);
+	return { record.fCost(), record.hCost };
+}
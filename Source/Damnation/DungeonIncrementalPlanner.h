@@ -0,0 +1,86 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DungeonPathfinding.h"
+
+/*
+* D* Lite planner for a single pather chasing a moving target.
+* The search runs backwards from a virtual goal node, linked to whichever tile the target is on by a zero cost edge.
+* The target moving is then just that edge moving, & the pather moving is absorbed by the key modifier, so the search tree
+* is kept between turns & only the part invalidated by the moves or by tile graph changes (read from its journal) is repaired.
+* Steps cost 1; like the tormentors' other paths, occupants are not treated as obstacles.
+* Links aren't assumed to be two way, the planner tracks which tiles link onto which so one way links are repaired too.
+*/
+class DAMNATION_API FDungeonIncrementalPlanner
+{
+public:
+	explicit FDungeonIncrementalPlanner(int actorSize = 1) : ActorSize(actorSize) {}
+
+	/*
+	* Plans from start to goal, repairing the previous plan where possible.
+	* Fills outPath with the tiles after start up to & including goal. Returns false if goal can't be reached.
+	*/
+	bool Plan(const FDungeonTileGraph& graph, int32 start, int32 goal, TArray<int32>& outPath);
+
+	// Discards the search tree, the next plan starts from scratch.
+	void Reset() { bInitialized = false; }
+
+	// Nodes expanded by the last plan, for comparing against a full search.
+	int32 GetLastExpansions() const { return LastExpansions; }
+
+private:
+	struct FKey
+	{
+		float Primary;
+		float Secondary;
+
+		bool operator<(const FKey& other) const
+		{
+			return Primary < other.Primary || (Primary == other.Primary && Secondary < other.Secondary);
+		}
+	};
+
+	void Initialize(const FDungeonTileGraph& graph, int32 start, int32 goal);
+
+	// Steps from the pather, see FDungeonTileGraph::EstimateSteps. The virtual goal uses the targets' tile.
+	float Heuristic(const FDungeonTileGraph& graph, int32 node) const;
+	FKey CalculateKey(const FDungeonTileGraph& graph, int32 node) const;
+	bool CanEnter(const FDungeonTileGraph& graph, int32 tile) const;
+	static bool LinksTo(const FDungeonTileGraph& graph, int32 from, int32 to);
+
+	// Refreshes the recorded links of a changed tile & the one way links at either end of any that changed.
+	void UpdateLinks(const FDungeonTileGraph& graph, int32 tile);
+	void UpdateOneWayLinks(const FDungeonTileGraph& graph, int32 a, int32 b);
+
+	void UpdateVertex(const FDungeonTileGraph& graph, int32 node);
+	// Updates every tile with an edge leading onto node.
+	void UpdatePredecessors(const FDungeonTileGraph& graph, int32 node);
+	void ComputeShortestPath(const FDungeonTileGraph& graph);
+
+	// Open list functionality
+	// The contexts' heap orders by gCost + hCost then hCost, so a key is stored as gCost = heuristic + modifier & hCost = cost.
+	void OpenPush(const FDungeonTileGraph& graph, int32 node);
+	FKey GetOpenKey(int32 node) const;
+
+	int ActorSize;
+	bool bInitialized = false;
+
+	// Index of the virtual goal node, one past the last tile
+	int32 GoalNode = INDEX_NONE;
+	int32 Start = INDEX_NONE;
+	int32 Goal = INDEX_NONE;
+	float KeyModifier = 0.0f;
+	uint32 JournalPosition = 0;
+	int32 LastExpansions = 0;
+
+	TArray<float> G;
+	TArray<float> Rhs;
+	FDungeonPathContext Context;
+
+	// Every tiles' links as of the last plan, CardinalCount per tile, to spot which changed
+	TArray<int32> Links;
+	// Tiles linking onto a tile that doesn't link back, keyed by the tile linked onto
+	TMultiMap<int32, int32> OneWayPredecessors;
+};
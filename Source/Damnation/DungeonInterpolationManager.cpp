@@ -0,0 +1,30 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DungeonInterpolationManager.h"
+#include "DungeonTileOccupant.h"
+#include "DungeonStats.h"
+
+void FDungeonInterpolationManager::Add(ADungeonTileOccupant* occupant)
+{
+	if (!occupant)
+		return;
+	if (!World.IsValid())
+		World = occupant->GetWorld();
+	// Few occupants move at once, so a linear search is cheaper than keeping a set
+	Active.AddUnique(occupant);
+}
+
+void FDungeonInterpolationManager::Tick(float DeltaTime)
+{
+	DUNGEON_SCOPE_CYCLE_COUNTER(STAT_DungeonInterpolation);
+	SET_DWORD_STAT(STAT_DungeonInterpolatingOccupants, Active.Num());
+	for (int32 i = Active.Num() - 1; i >= 0; --i)
+	{
+		ADungeonTileOccupant* occupant = Active[i].Get();
+		if (occupant && occupant->AdvanceInterpolation(DeltaTime))
+			continue;
+		Active.RemoveAtSwap(i, 1, false);
+		if (occupant)
+			occupant->SleepInterpolation();
+	}
+}
@@ -0,0 +1,35 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Tickable.h"
+
+class ADungeonTileOccupant;
+
+/*
+* Moves the lagged roots of every occupant that's mid-action in one update per frame.
+* Occupants are added by ADungeonTileOccupant::WakeInterpolation when they act & dropped once they've caught up,
+* at which point they go back to sleep. Nothing ticks while every occupant is standing still.
+* Only used on the game thread.
+*/
+class DAMNATION_API FDungeonInterpolationManager : public FTickableGameObject
+{
+public:
+	// Adds occupant to the next update if it isn't already in it.
+	void Add(ADungeonTileOccupant* occupant);
+
+	// Number of occupants being interpolated.
+	int32 Num() const { return Active.Num(); }
+
+	// FTickableGameObject
+	virtual void Tick(float DeltaTime) override;
+	virtual bool IsTickable() const override { return Active.Num() > 0; }
+	virtual UWorld* GetTickableGameObjectWorld() const override { return World.Get(); }
+	virtual TStatId GetStatId() const override { RETURN_QUICK_DECLARE_CYCLE_STAT(FDungeonInterpolationManager, STATGROUP_Tickables); }
+
+private:
+	TArray<TWeakObjectPtr<ADungeonTileOccupant>> Active;
+	// Taken from the first occupant added, so only that worlds' tick updates this
+	TWeakObjectPtr<UWorld> World;
+};
@@ -0,0 +1,179 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DungeonJumpPointSearch.h"
+
+namespace
+{
+	// FDungeonTileGraph axes, X on even values
+	enum EJumpDirection
+	{
+		PositiveX,
+		PositiveY,
+		NegativeX,
+		NegativeY,
+		JumpDirectionCount
+	};
+
+	bool IsAlongX(int32 direction) { return direction % 2 == 0; }
+
+	class FJumpPointSearcher
+	{
+	public:
+		FJumpPointSearcher(const FDungeonTileGraph& graph, const FDungeonPathQuery& query) : Graph(graph), Query(query) {}
+
+		// The tile one step from tile in direction, INDEX_NONE if there's no link that way or the pather can't enter it.
+		int32 Step(int32 tile, int32 direction) const
+		{
+			int32 connection = Graph.GetNeighbourOnAxis(tile, direction);
+			return connection != INDEX_NONE && CanEnter(connection) ? connection : INDEX_NONE;
+		}
+
+		// Moving along Y from previous onto tile, whether turning onto X toward side must be considered here.
+		// Only if the route moving along X first, from previous, isn't available.
+		bool IsForced(int32 previous, int32 tile, int32 direction, int32 side) const
+		{
+			int32 turn = Step(tile, side);
+			if (turn == INDEX_NONE)
+				return false;
+			int32 alternative = Step(previous, side);
+			return alternative == INDEX_NONE || Step(alternative, direction) != turn;
+		}
+
+		// Jumps along Y, stopping on the target or a tile with a forced turn. Returns INDEX_NONE if neither are reached.
+		int32 JumpY(int32 tile, int32 direction, int32& outSteps) const
+		{
+			outSteps = 0;
+			int32 current = tile;
+			while (true)
+			{
+				int32 next = Step(current, direction);
+				if (next == INDEX_NONE)
+					return INDEX_NONE;
+				++outSteps;
+				if (next == Query.End || IsForced(current, next, direction, PositiveX) || IsForced(current, next, direction, NegativeX))
+					return next;
+				current = next;
+			}
+		}
+
+		// Jumps along X, stopping on the target or a tile a jump along Y from which finds something.
+		int32 JumpX(int32 tile, int32 direction, int32& outSteps) const
+		{
+			outSteps = 0;
+			int32 current = tile;
+			int32 ignored;
+			while (true)
+			{
+				int32 next = Step(current, direction);
+				if (next == INDEX_NONE)
+					return INDEX_NONE;
+				++outSteps;
+				if (next == Query.End || JumpY(next, PositiveY, ignored) != INDEX_NONE || JumpY(next, NegativeY, ignored) != INDEX_NONE)
+					return next;
+				current = next;
+			}
+		}
+
+		// Direction of a straight jump from one tile to another.
+		int32 GetDirection(int32 from, int32 to) const
+		{
+			FVector offset = Graph.GetLocation(to) - Graph.GetLocation(from);
+			if (FMath::Abs(offset.X) > FMath::Abs(offset.Y))
+				return offset.X > 0.0f ? PositiveX : NegativeX;
+			return offset.Y > 0.0f ? PositiveY : NegativeY;
+		}
+
+		float Heuristic(int32 tile) const { return Graph.EstimateSteps(tile, Query.End); }
+
+	private:
+		bool CanEnter(int32 tile) const
+		{
+			return Graph.GetAvailableSpace(tile) >= Query.ActorSize && !Graph.IsPathingIgnored(tile);
+		}
+
+		const FDungeonTileGraph& Graph;
+		const FDungeonPathQuery& Query;
+	};
+}
+
+bool FDungeonJumpPointSearch::FindPath(const FDungeonTileGraph& graph, FDungeonPathContext& context, const FDungeonPathQuery& query, TArray<int32>& outPath)
+{
+	outPath.Reset();
+
+	const int32 start = query.Start;
+	const int32 end = query.End;
+	if (start == end || query.bRespectOccupants || !graph.IsValidTile(start) || !graph.IsValidTile(end))
+		return false;
+
+	FJumpPointSearcher searcher(graph, query);
+	context.Begin(graph.Num());
+	context.GetNode(start).hCost = searcher.Heuristic(start);
+	context.Push(start);
+
+	while (context.OpenNum() > 0)
+	{
+		int32 current = context.Pop();
+		FDungeonPathNode& currentNode = context.GetNode(current);
+		currentNode.bClosed = true;
+
+		if (current == end)
+		{
+			// Walk back through the jump points, filling in the straight runs between them
+			TArray<int32> jumpPoints;
+			for (int32 point = end; point != start; point = context.GetNode(point).Parent)
+				jumpPoints.Add(point);
+			int32 from = start;
+			for (int32 i = jumpPoints.Num() - 1; i >= 0; --i)
+			{
+				int32 direction = searcher.GetDirection(from, jumpPoints[i]);
+				while (from != jumpPoints[i])
+				{
+					from = searcher.Step(from, direction);
+					outPath.Add(from);
+				}
+			}
+			return true;
+		}
+
+		// Prune the directions the canonical path from the parent could take from here
+		bool directions[JumpDirectionCount] = { true, true, true, true };
+		if (currentNode.Parent != INDEX_NONE)
+		{
+			int32 arrival = searcher.GetDirection(currentNode.Parent, current);
+			int32 back = (arrival + 2) % JumpDirectionCount;
+			directions[back] = false;
+			if (!IsAlongX(arrival))
+			{
+				// Arrived moving along Y, only keep the turns onto X the tile before couldn't have made
+				int32 previous = searcher.Step(current, back);
+				for (int32 side : { PositiveX, NegativeX })
+					directions[side] = previous == INDEX_NONE || searcher.IsForced(previous, current, arrival, side);
+			}
+		}
+
+		for (int32 direction = 0; direction < JumpDirectionCount; ++direction)
+		{
+			if (!directions[direction])
+				continue;
+			int32 steps = 0;
+			int32 jumpPoint = IsAlongX(direction) ? searcher.JumpX(current, direction, steps) : searcher.JumpY(current, direction, steps);
+			if (jumpPoint == INDEX_NONE || context.IsClosed(jumpPoint))
+				continue;
+
+			float moveCost = currentNode.gCost + steps;
+			bool bInOpenList = context.IsOpen(jumpPoint);
+			FDungeonPathNode& jumpNode = context.GetNode(jumpPoint);
+			if (moveCost < jumpNode.gCost || !bInOpenList)
+			{
+				jumpNode.gCost = moveCost;
+				jumpNode.hCost = searcher.Heuristic(jumpPoint);
+				jumpNode.Parent = current;
+				if (bInOpenList)
+					context.Update(jumpPoint);
+				else
+					context.Push(jumpPoint);
+			}
+		}
+	}
+	return false;
+}
@@ -0,0 +1,22 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DungeonPathfinding.h"
+
+/*
+* Jump point search for 4-connected, uniform cost movement over FDungeonTileGraph.
+* Runs of tiles are skipped over in straight lines & only the tiles where a path may have to turn are added to the open list,
+* so open rooms & arenas are crossed with a handful of expansions rather than one per tile.
+* Paths prefer moving along X before Y; moving along Y may only turn back to X where the X first route is blocked.
+* Directions are taken from the graphs' axis neighbours rather than connection slots, as the slot a link is stored in depends on the
+* order tiles were linked in. Missing & one-way links are handled by checking the alternative route exists, not just the tile.
+* Only valid when every step costs the same, so occupant weighting is not supported.
+*/
+struct DAMNATION_API FDungeonJumpPointSearch
+{
+	// Fills outPath with the tile indices from the tile after Start up to & including End, the shortest path in steps.
+	// Returns false if End can't be reached or the query respects occupants; bGetClosest is ignored.
+	static bool FindPath(const FDungeonTileGraph& graph, FDungeonPathContext& context, const FDungeonPathQuery& query, TArray<int32>& outPath);
+};
@@ -2,6 +2,20 @@
 
 #include "DungeonMacroGrid.h"
 #include "DamnationGameModeBase.h"
+#include "DungeonJumpPointSearch.h"
+#include "DungeonGameInstanceBase.h"
+#include "DungeonStats.h"
+#include "EngineUtils.h"
+#include "Serialization/ArchiveCountMem.h"
+
+namespace
+{
+	// Bytes used by object, counted the same way as "obj list": its properties plus everything they allocate.
+	SIZE_T GetObjectBytes(UObject* object)
+	{
+		return object->GetClass()->GetPropertiesSize() + FArchiveCountMem(object).GetMax();
+	}
+}
 
 // Sets default values
 ADungeonMacroGrid::ADungeonMacroGrid()
@@ -9,19 +23,14 @@ ADungeonMacroGrid::ADungeonMacroGrid()
 	DirectionalBiases.Init(1.0, 4);
 
 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = false;
+	// Only ticks while generating a floor over multiple frames.
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
 
 	MapOrigin = CreateDefaultSubobject<USceneComponent>(TEXT("Handle"));
 	RootComponent = MapOrigin;
 }
 
-float ADungeonMacroGrid::GetFill()
-{
-	float cFill = maxFillChance;
-	maxFillChance = FMath::Max(maxFillChance - fillChanceVelocity, minFillChance);
-	return cFill;
-}
-
 // Called when the game starts or when spawned
 void ADungeonMacroGrid::BeginPlay()
 {
@@ -42,46 +51,63 @@ void ADungeonMacroGrid::PostInitializeComponents()
 
 	// Allocate space to be ready for additions
 	RoomGridFlatArray.Init(nullptr, FlatArraySize);
+
+	PathCache.SetCapacity(PathCacheSize);
+	// Room positions run along X up to the grid height & along Y up to its width, see IsValidSpace
+	SightMap.Init(GetActorLocation(), ArrayHeight, ArrayWidth);
+
+	// Tiles only get an actor once something asks for one
+	TWeakObjectPtr<ADungeonMacroGrid> weakThis(this);
+	TileGraph.SetProxyFactory([weakThis](int32 index) { return weakThis.IsValid() ? weakThis->GetTileProxy(index) : nullptr; });
 }
 
 inline void ADungeonMacroGrid::ConnectNorthRooms(ADungeonRoomTileBase* roomA, ADungeonRoomTileBase* roomB)
 {
 	for (int y = 0; y < 15; ++y)
-		if (roomA->GetTile(FVector2D(14, y)) && roomB->GetTile(FVector2D(0, y)))
-		{
-			roomA->GetTile(FVector2D(14, y))->CardinalConnections[0] = roomB->GetTile(FVector2D(0, y));
-			roomB->GetTile(FVector2D(0, y))->CardinalConnections[2] = roomA->GetTile(FVector2D(14, y));
-		}
+	{
+		int32 tileA = roomA->GetTileIndex(FVector2D(14, y));
+		int32 tileB = roomB->GetTileIndex(FVector2D(0, y));
+		if (tileA != INDEX_NONE && tileB != INDEX_NONE)
+			LinkTiles(tileA, ECardinal::NORTH, tileB, ECardinal::SOUTH);
+	}
 }
 
 inline void ADungeonMacroGrid::ConnectEastRooms(ADungeonRoomTileBase* roomA, ADungeonRoomTileBase* roomB)
 {
 	for (int x = 0; x < 15; ++x)
-		if (roomA->GetTile(FVector2D(x, 14)) && roomB->GetTile(FVector2D(x, 0)))
-		{
-			roomA->GetTile(FVector2D(x, 14))->CardinalConnections[1] = roomB->GetTile(FVector2D(x, 0));
-			roomB->GetTile(FVector2D(x, 0))->CardinalConnections[3] = roomA->GetTile(FVector2D(x, 14));
-		}
+	{
+		int32 tileA = roomA->GetTileIndex(FVector2D(x, 14));
+		int32 tileB = roomB->GetTileIndex(FVector2D(x, 0));
+		if (tileA != INDEX_NONE && tileB != INDEX_NONE)
+			LinkTiles(tileA, ECardinal::EAST, tileB, ECardinal::WEST);
+	}
 }
 
 inline void ADungeonMacroGrid::ConnectSouthRooms(ADungeonRoomTileBase* roomA, ADungeonRoomTileBase* roomB)
 {
 	for (int y = 0; y < 15; ++y)
-		if (roomA->GetTile(FVector2D(0, y)) && roomB->GetTile(FVector2D(14, y)))
-		{
-			roomA->GetTile(FVector2D(0, y))->CardinalConnections[2] = roomB->GetTile(FVector2D(14, y));
-			roomB->GetTile(FVector2D(14, y))->CardinalConnections[0] = roomA->GetTile(FVector2D(0, y));
-		}
+	{
+		int32 tileA = roomA->GetTileIndex(FVector2D(0, y));
+		int32 tileB = roomB->GetTileIndex(FVector2D(14, y));
+		if (tileA != INDEX_NONE && tileB != INDEX_NONE)
+			LinkTiles(tileA, ECardinal::SOUTH, tileB, ECardinal::NORTH);
+	}
 }
 
 inline void ADungeonMacroGrid::ConnectWestRooms(ADungeonRoomTileBase* roomA, ADungeonRoomTileBase* roomB)
 {
 	for (int x = 0; x < 15; ++x)
-		if (roomA->GetTile(FVector2D(x, 0)) && roomB->GetTile(FVector2D(x, 14)))
-		{
-			roomA->GetTile(FVector2D(x, 0))->CardinalConnections[3] = roomB->GetTile(FVector2D(x, 14));
-			roomB->GetTile(FVector2D(x, 14))->CardinalConnections[1] = roomA->GetTile(FVector2D(x, 0));
-		}
+	{
+		int32 tileA = roomA->GetTileIndex(FVector2D(x, 0));
+		int32 tileB = roomB->GetTileIndex(FVector2D(x, 14));
+		if (tileA != INDEX_NONE && tileB != INDEX_NONE)
+			LinkTiles(tileA, ECardinal::WEST, tileB, ECardinal::EAST);
+	}
+}
+
+int32 ADungeonMacroGrid::UpdateClearance()
+{
+	return TileGraph.UpdateClearance();
 }
 
 void ADungeonMacroGrid::SetPlayerLocation(ADungeonSingleTile* tile)
@@ -111,59 +137,68 @@ ADungeonRoomTileBase* ADungeonMacroGrid::AddRoom(FVector2D position, TSubclassOf
 	}
 	else
 	{
-		FTransform transform(GetActorLocation() + (UKismetMathLibrary::Conv_Vector2DToVector(position)) * ADungeonRoomTileBase::RoomPositionScalar);
-		FActorSpawnParameters spawnParams;
-		spawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
-		room = GetWorld()->SpawnActor<ADungeonRoomTileBase>(roomType, transform, spawnParams);
-		room->SetMacroGrid(this);
-
-		RoomGridFlatArray[GridToFlatIndex(position)] = room;
-
+		room = SpawnRoom(position, roomType);
 		room->LoadTextureToMap();
+		StitchRoom(room, position);
+		// Only the new room & the borders it was stitched to need their space recomputed
+		UpdateClearance();
+		room->OnMapFinalization();
+	}
+	return room;
+}
 
-		// Scan valid cardinals for rooms to see if they can be connected to
-		ADungeonRoomTileBase* adjRoom = nullptr;
+ADungeonRoomTileBase* ADungeonMacroGrid::SpawnRoom(FVector2D position, TSubclassOf<ADungeonRoomTileBase> roomType)
+{
+	FTransform transform(GetActorLocation() + (UKismetMathLibrary::Conv_Vector2DToVector(position)) * ADungeonRoomTileBase::RoomPositionScalar);
+	// Only poolable rooms are ever released to the pool, so others are always spawned
+	ADungeonRoomTileBase* room = ActorPool.Acquire<ADungeonRoomTileBase>(GetWorld(), roomType, transform);
+	room->SetMacroGrid(this);
+	room->SetRoomIndex(GridToFlatIndex(position));
+	// Seeded by position rather than spawn order
+	room->SeedRandom(Gamemode ? Gamemode->GetStreamSeed(EDungeonRandomStream::ROOM, GridToFlatIndex(position)) : FMath::Rand());
+
+	RoomGridFlatArray[GridToFlatIndex(position)] = room;
+	OccupiedRooms.Add(GridToFlatIndex(position));
+	return room;
+}
+
+void ADungeonMacroGrid::StitchRoom(ADungeonRoomTileBase* room, FVector2D position, uint8 directions)
+{
+	// Scan valid cardinals for rooms to see if they can be connected to
+	ADungeonRoomTileBase* adjRoom = nullptr;
 
-		if (room->ValidCardinals[0])
+	if ((directions & 1) && room->ValidCardinals[0])
+	{
+		adjRoom = GetRoom(position + FVector2D(1, 0));
+		if (adjRoom && adjRoom->ValidCardinals[2])
 		{
-			adjRoom = GetRoom(position + FVector2D(1, 0));
-			if (adjRoom && adjRoom->ValidCardinals[2])
-			{
-				ConnectNorthRooms(room, adjRoom);
-				adjRoom->AssignSizes();
-			}
+			ConnectNorthRooms(room, adjRoom);
 		}
-		if (room->ValidCardinals[1])
+	}
+	if ((directions & 2) && room->ValidCardinals[1])
+	{
+		adjRoom = GetRoom(position + FVector2D(0, 1));
+		if (adjRoom && adjRoom->ValidCardinals[3])
 		{
-			adjRoom = GetRoom(position + FVector2D(0, 1));
-			if (adjRoom && adjRoom->ValidCardinals[3])
-			{
-				ConnectEastRooms(room, adjRoom);				
-				adjRoom->AssignSizes();
-			}
+			ConnectEastRooms(room, adjRoom);
 		}
-		if (room->ValidCardinals[2])
+	}
+	if ((directions & 4) && room->ValidCardinals[2])
+	{
+		adjRoom = GetRoom(position + FVector2D(-1, 0));
+		if (adjRoom && adjRoom->ValidCardinals[0])
 		{
-			adjRoom = GetRoom(position + FVector2D(-1, 0));
-			if (adjRoom && adjRoom->ValidCardinals[0])
-			{
-				ConnectSouthRooms(room, adjRoom);
-				adjRoom->AssignSizes();
-			}
+			ConnectSouthRooms(room, adjRoom);
 		}
-		if (room->ValidCardinals[3])
+	}
+	if ((directions & 8) && room->ValidCardinals[3])
+	{
+		adjRoom = GetRoom(position + FVector2D(0, -1));
+		if (adjRoom && adjRoom->ValidCardinals[1])
 		{
-			adjRoom = GetRoom(position + FVector2D(0, -1));
-			if (adjRoom && adjRoom->ValidCardinals[1])
-			{
-				ConnectWestRooms(room, adjRoom);
-				adjRoom->AssignSizes();
-			}
+			ConnectWestRooms(room, adjRoom);
 		}
-		room->AssignSizes();
-		room->OnMapFinalization();
 	}
-	return room;
 }
 
 ADungeonRoomTileBase* ADungeonMacroGrid::GetRoom(FVector2D position)
@@ -188,23 +223,9 @@ ADungeonRoomTileBase* ADungeonMacroGrid::GetRoomByWorldPosition(FVector position
 
 ADungeonRoomTileBase* ADungeonMacroGrid::GetRoomRandom()
 {
-	// Make array of all Indices
-	TArray<uint32> possibleIndices;
-	uint32 roomCount = RoomGridFlatArray.Num();
-	possibleIndices.Init(0, FlatArraySize);
-	for (int i = 0; i < FlatArraySize; ++i)
-		possibleIndices[i] = i;
-	// Shuffle array so indices in array order 0..Num() act as a "random shuffle"
-	ShuffleArray<uint32>(possibleIndices);
-	// Iterate through indices from 0 to end and return the first valid result
-	ADungeonRoomTileBase* randRoom;
-	for (int i = 0; i < FlatArraySize; ++i)
-	{
-		randRoom = GetRoomByIndex(possibleIndices[i]);
-		if (randRoom)
-			return randRoom;
-	}
-	return nullptr;
+	if (OccupiedRooms.Num() == 0)
+		return nullptr;
+	return RoomGridFlatArray[OccupiedRooms[Random.RandRange(0, OccupiedRooms.Num() - 1)]];
 }
 
 bool ADungeonMacroGrid::IsValidSpace(FVector2D position)
@@ -214,72 +235,210 @@ bool ADungeonMacroGrid::IsValidSpace(FVector2D position)
 
 TArray<ADungeonSingleTile*> ADungeonMacroGrid::GeneratePath(ADungeonSingleTile* start, ADungeonSingleTile* end, int actorSize, bool getClosest, bool respectOccupants)
 {
-	// Return empty if start == end, standing on desired tile
-	if (start == end)
+	DUNGEON_SCOPE_CYCLE_COUNTER(STAT_DungeonPathfinding);
+	PathRequestCount.Increment();
+	UpdateRoomGraph();
+
+	FDungeonPathQuery query;
+	if (!start || !end || !MakePathQuery(start->TileIndex, end->TileIndex, actorSize, getClosest, respectOccupants, query))
 		return TArray<ADungeonSingleTile*>();
 
 	TArray<ADungeonSingleTile*> DesiredPath;
+	TArray<int32> path;
+	bool found = false;
+	if (!PathCache.Find(TileGraph, query, path, found))
+	{
+		FDungeonScopedPathContext context(PathContexts);
+		found = FindPath(context.Get(), query, path);
+		PathCache.Add(TileGraph, query, path, found);
+	}
+	if (found)
+		TileGraph.ToTiles(path, DesiredPath);
+	return DesiredPath;
+}
+
+bool ADungeonMacroGrid::GeneratePath(FDungeonPathContext& context, int32 start, int32 end, TArray<int32>& outPath, int actorSize, bool getClosest, bool respectOccupants) const
+{
+	DUNGEON_SCOPE_CYCLE_COUNTER(STAT_DungeonPathfinding);
+	PathRequestCount.Increment();
+	outPath.Reset();
+	FDungeonPathQuery query;
+	if (!MakePathQuery(start, end, actorSize, getClosest, respectOccupants, query))
+		return false;
+	// Converting to tiles can spawn proxies, so that's left to the caller back on the game thread
+	return FindPath(context, query, outPath);
+}
+
+bool ADungeonMacroGrid::FindPath(FDungeonPathContext& context, const FDungeonPathQuery& query, TArray<int32>& outPath) const
+{
+	// Occupancy changes every turn, so only unweighted queries can go through the room graph or jump point search.
+	// If neither can answer the query it falls through to A*, which also handles getClosest.
+	if (!query.bRespectOccupants)
+	{
+		FDungeonRoomRoute route;
+		if (RoomGraph.FindRoute(TileGraph, context, query.Start, query.End, query.ActorSize, route) && route.RefineAll(TileGraph, outPath))
+			return true;
+		if (FDungeonJumpPointSearch::FindPath(TileGraph, context, query, outPath))
+			return true;
+		// Jump point search fails the same way A* does when the end can't be reached, so only closest tile queries need to rerun
+		if (!query.bGetClosest)
+			return false;
+	}
+	return FDungeonPathfinder::FindPath(TileGraph, context, query, outPath);
+}
+
+FDungeonAsyncPathHandle ADungeonMacroGrid::GeneratePathAsync(ADungeonSingleTile* start, ADungeonSingleTile* end, int actorSize, bool getClosest, bool respectOccupants, FDungeonAsyncPathfinder::FOnComplete onComplete)
+{
+	PathRequestCount.Increment();
+	FDungeonPathQuery query;
+	if (!start || !end || !MakePathQuery(start->TileIndex, end->TileIndex, actorSize, getClosest, respectOccupants, query))
+		return nullptr;
+	// Space must be current before the graph is copied
+	TileGraph.UpdateClearance();
+	return AsyncPathfinder.Request(TileGraph, query, onComplete);
+}
+
+bool ADungeonMacroGrid::MakePathQuery(int32 start, int32 end, int actorSize, bool getClosest, bool respectOccupants, FDungeonPathQuery& outQuery) const
+{
+	// Tiles that weren't added through a room on this grid can't be pathed through
+	if (!TileGraph.IsValidTile(start) || !TileGraph.IsValidTile(end))
+		return false;
+
+	outQuery.Start = start;
+	outQuery.End = end;
+	outQuery.ActorSize = actorSize;
+	outQuery.bGetClosest = getClosest;
+	outQuery.bRespectOccupants = respectOccupants;
+	outQuery.IgnoredOccupant = Gamemode ? FDungeonTileGraph::MakeOccupantHandle(Gamemode->ActivePlayer) : 0;
+	return true;
+}
+
+bool ADungeonMacroGrid::GenerateRoute(ADungeonSingleTile* start, ADungeonSingleTile* end, int actorSize, FDungeonRoomRoute& outRoute)
+{
+	DUNGEON_SCOPE_CYCLE_COUNTER(STAT_DungeonPathfinding);
+	PathRequestCount.Increment();
+	outRoute.Reset();
+	if (!start || !end || start->TileIndex == INDEX_NONE || end->TileIndex == INDEX_NONE)
+		return false;
+
+	UpdateRoomGraph();
+	FDungeonScopedPathContext context(PathContexts);
+	return RoomGraph.FindRoute(TileGraph, context.Get(), start->TileIndex, end->TileIndex, actorSize, outRoute);
+}
+
+bool ADungeonMacroGrid::RefineRoute(FDungeonRoomRoute& route, TArray<ADungeonSingleTile*>& outPath) const
+{
+	TArray<int32> segment;
+	if (!route.RefineNext(TileGraph, segment))
+		return false;
+	for (int32 index : segment)
+		outPath.Add(TileGraph.GetTile(index));
+	return true;
+}
+
+ADungeonSingleTile* ADungeonMacroGrid::AcquireTile(const FVector& location)
+{
+	return ActorPool.Acquire<ADungeonSingleTile>(GetWorld(), ADungeonSingleTile::StaticClass(), FTransform(location));
+}
 
-	TArray<ADungeonSingleTile*> AS_openTileList;
-	TSet<ADungeonSingleTile*> AS_closedTileList;
+void ADungeonMacroGrid::ReleaseTile(ADungeonSingleTile* tile)
+{
+	tile->ResetTile();
+	ActorPool.Release(tile);
+}
+
+int32 ADungeonMacroGrid::RegisterTile(const FVector& location, int32 room, int32 localIndex)
+{
+	int32 index = TileGraph.AddTile(nullptr, location, room, localIndex);
+	SightMap.AddTile(index, location);
+	return index;
+}
 
-	AS_openTileList.Add(start);
-	ADungeonSingleTile* current = AS_openTileList[0];
-	current->hCost = current->GetSquaredDistanceTo(end);
-	// Store closest tile to target every iteration incase pathfinding fails
-	ADungeonSingleTile* closest = current;
+void ADungeonMacroGrid::LinkTiles(int32 a, ECardinal aToB, int32 b, ECardinal bToA)
+{
+	TileGraph.SetConnection(a, (int32)aToB, b);
+	TileGraph.SetConnection(b, (int32)bToA, a);
+	if (ADungeonSingleTile* tileA = TileGraph.FindTile(a))
+		tileA->CardinalConnections[(uint8)aToB] = TileGraph.FindTile(b);
+	if (ADungeonSingleTile* tileB = TileGraph.FindTile(b))
+		tileB->CardinalConnections[(uint8)bToA] = TileGraph.FindTile(a);
+}
+
+ADungeonSingleTile* ADungeonMacroGrid::GetTileProxy(int32 index)
+{
+	if (!TileGraph.IsValidTile(index))
+		return nullptr;
+	ADungeonSingleTile* tile = TileGraph.FindTile(index);
+	if (tile)
+		return tile;
+
+	tile = AcquireTile(TileGraph.GetLocation(index));
+	tile->SetTileGraph(&TileGraph, index);
+	TileGraph.SetTile(index, tile);
+	tile->SyncConnections();
+	// Neighbours spawned earlier couldn't mirror their connection to this tile
+	for (int32 dir = 0; dir < FDungeonTileGraph::CardinalCount; ++dir)
+	{
+		ADungeonSingleTile* neighbour = TileGraph.FindTile(TileGraph.GetNeighbour(index, dir));
+		if (neighbour)
+			neighbour->SyncConnections();
+	}
+	// Rooms hold their tiles' proxies for Blueprint access & release them with the room
+	ADungeonRoomTileBase* room = GetRoomByIndex(TileGraph.GetRoom(index));
+	if (room)
+		room->SetTileProxy(TileGraph.GetLocalIndex(index), tile);
+	return tile;
+}
 
-	while (AS_openTileList.Num() > 0)
+void ADungeonMacroGrid::LogTileMemory() const
+{
+	const int32 tileCount = TileGraph.Num();
+	if (tileCount == 0)
+		return;
+	int32 proxyCount = 0;
+	SIZE_T proxyBytes = 0;
+	TInlineComponentArray<UActorComponent*> components;
+	for (int32 index = 0; index < tileCount; ++index)
 	{
-		current = AS_openTileList[0];
-		if (current->GetSquaredDistanceTo(end) < closest->hCost) closest = current;
-		AS_openTileList.RemoveAt(0);
-		AS_closedTileList.Add(current);
-		if (current == end)
-		{
-			DesiredPath.Empty();
-			DesiredPath.Add(current);
-			while (current->parent != start && current != start)
-			{
-				DesiredPath.Add(current->parent);
-				current = current->parent;
-			}
-			DesiredPath.Shrink();
-			Algo::Reverse<TArray<ADungeonSingleTile*>>(DesiredPath);
-			return DesiredPath;
-		}
-		for (auto connection : current->CardinalConnections)
-		{
-			// IF
-			// Connection exists, the closed list has the connection already, there's not enough space for the pather, or if the tile is set to be ignored
-			if (!connection ||
-				AS_closedTileList.Contains(connection) ||
-				connection->availableSpace < actorSize ||
-				connection->bPathingIgnore)
-				continue;
-			float sqrDistance = current->GetSquaredDistanceTo(end);
-			// If the tile is occupied, increase the cost to encourage routing around obstacles.
-			if (respectOccupants && connection->OccupyingActor && connection->OccupyingActor != Gamemode->ActivePlayer)
-				sqrDistance *= 1.1;
-
-			float moveCost = current->gCost + sqrDistance;
-			if (moveCost < connection->gCost || !AS_openTileList.Contains(connection))
-			{
-				connection->gCost = moveCost;
-				connection->hCost = sqrDistance;
-				connection->parent = current;
-				if (!AS_openTileList.Contains(connection))
-					AS_openTileList.Add(connection);
-			}
-		}
-		// Sort list by f score
-		AS_openTileList.Sort([](const ADungeonSingleTile& LHS, const ADungeonSingleTile& RHS) {return LHS.fCost() < RHS.fCost(); });
+		ADungeonSingleTile* tile = TileGraph.FindTile(index);
+		if (!tile)
+			continue;
+		++proxyCount;
+		proxyBytes += GetObjectBytes(tile);
+		tile->GetComponents(components);
+		for (UActorComponent* component : components)
+			proxyBytes += GetObjectBytes(component);
 	}
-	// Cannot reach the desired position, pathfind to the closest valid position instead if desired.
-	if (getClosest)
-		return GeneratePath(start, closest, actorSize);
-	// Return empty array if closest valid isn't desired.
-	else return TArray<ADungeonSingleTile*>();
+
+	// Pooled tiles are still actors, so are counted too
+	int32 actorCount = 0;
+	int32 tileActorCount = 0;
+	for (TActorIterator<AActor> it(GetWorld()); it; ++it)
+	{
+		++actorCount;
+		if (it->IsA<ADungeonSingleTile>())
+			++tileActorCount;
+	}
+
+	const SIZE_T graphBytes = TileGraph.GetAllocatedSize();
+	UE_LOG(LogTemp, Display, TEXT("Tile memory: %d tiles, %d with proxy actors. %d actors in the world, %d of them tiles. Tile graph %.1fKB (%.1f bytes per tile), proxy actors %.1fKB (%.1f bytes each)"),
+		tileCount, proxyCount, actorCount, tileActorCount, graphBytes / 1024.0f, (float)graphBytes / tileCount,
+		proxyBytes / 1024.0f, proxyCount > 0 ? (float)proxyBytes / proxyCount : 0.0f);
+}
+
+bool ADungeonMacroGrid::HasLineOfSight(ADungeonSingleTile* from, ADungeonSingleTile* to) const
+{
+	if (!from || !to)
+		return false;
+	return SightMap.HasLineOfSight(from->TileIndex, to->TileIndex);
+}
+
+TArray<ADungeonSingleTile*> ADungeonMacroGrid::GetVisibleTiles(ADungeonSingleTile* origin, int radius)
+{
+	TArray<ADungeonSingleTile*> tiles;
+	if (origin)
+		TileGraph.ToTiles(SightMap.GetVisibleTiles(origin->TileIndex, radius), tiles);
+	return tiles;
 }
 
 FVector2D ADungeonMacroGrid::FlatToGridIndex(int index)
@@ -326,211 +485,240 @@ ADungeonSingleTile* ADungeonMacroGrid::GetTileAtWorldPosition(FVector position)
 	else return nullptr;
 }
 
+namespace
+{
+	// Tiles checked per unit of work while sizing
+	const int32 ClearanceTilesPerStep = 256;
+}
+
 // More logical map generation system taking connectors into account
 void ADungeonMacroGrid::GenerateFloor()
 {
-	// Jump table for positions
-	static const FVector2D jumpDirTable[4] =
-	{
-		FVector2D(1, 0),
-		FVector2D(0, 1),
-		FVector2D(-1, 0),
-		FVector2D(0, -1)
-	};
-	// Typedefs for ease of reading
-	// TConPair == direction & room position, representing a connector
-	// TConPairChance == TConPair + float, is TConPair with chance representing potential to spawn a new room there
-	typedef TPair<int, FVector2D> TConPair;
-	typedef TPair<TConPair, float> TConPairChance;
-
-	// List of rooms with with the # of times they're used to encourage variation in spawned rooms
-	typedef TPair<TSubclassOf<ADungeonRoomTileBase>, int> TRoomUses;
-	TArray<TRoomUses> RoomListUses;
-	RoomListUses.Init(TRoomUses(nullptr, 0), RoomList.Num());
-	for (int i = 0; i < RoomList.Num(); ++i)
-		RoomListUses[i] = TRoomUses(RoomList[i], 0);
-
-	AddRoom(StarterRoomPosition, StarterRoom);
-	AddRoom(StarterRoomPosition + FVector2D(1, 0), TutorialRoom);
-	FVector2D MuralRoomPosition = EscapeRoomPosition - FVector2D(1, 0);
-	AddRoom(EscapeRoomPosition, EscapeRoom);
-	AddRoom(MuralRoomPosition, MuralRoom);
-
-	TArray<TConPair> OpenConnectors;
-
-	// Connectors to starting split & mural
-	for (int i = 0; i < 3; ++i)
-	{
-		OpenConnectors.Add(TConPair((i + 1) % 4, MuralRoomPosition));
-	}
+	BeginFloorGeneration(false);
+	StepFloorGeneration(0.0f);
+}
 
-	// Do Bresenham's Line Algorithm to make guaranteed path between start & end positions
-	{
-		// Find all rooms that are 4-way to put in list
-		TArray<TRoomUses> validRooms;
-		for (TRoomUses roomUses : RoomListUses)
-		{
-			bool roomValid = true;
-			for (int i = 0; i < 4; ++i)
-				if (!roomUses.Key.GetDefaultObject()->ValidCardinals[i])
-				{
-					roomValid = false;
-					break;
-				}
-			if (roomValid)
-				validRooms.Add(roomUses);
-		}
+void ADungeonMacroGrid::GenerateFloorTimeSliced()
+{
+	BeginFloorGeneration(true);
+	SetActorTickEnabled(true);
+}
 
-		int x0 = StarterRoomPosition.X;
-		int y0 = StarterRoomPosition.Y;
-		int x1 = MuralRoomPosition.X;
-		int y1 = MuralRoomPosition.Y;
+void ADungeonMacroGrid::BeginFloorGeneration(bool bGameSetup)
+{
+	Generation = FFloorGenerationState();
+	Generation.bGameSetup = bGameSetup;
+	Generation.Phase = EFloorGenerationPhase::LAYOUT;
 
-		int mNew = 2 * (y1 - y0);
-		int slopeError = mNew - (x1 - x0);
+	// Without a game mode there's no floor seed, so the floor can't be reproduced
+	int32 floorSeed = Gamemode ? Gamemode->GetFloorSeed() : FMath::Rand();
+	Random.Initialize(ADamnationGameModeBase::MakeStreamSeed(floorSeed, EDungeonRandomStream::GRID));
+	int32 layoutSeed = ADamnationGameModeBase::MakeStreamSeed(floorSeed, EDungeonRandomStream::LAYOUT);
 
-		for (int x = x0, y = y0; x <= x1; ++x)
+	if (NextLayout.IsValid())
+	{
+		// Waits for the solver if it's still going
+		TSharedPtr<FDungeonFloorLayoutSolver, ESPMode::ThreadSafe> solved = NextLayout.Get();
+		NextLayout = TFuture<TSharedPtr<FDungeonFloorLayoutSolver, ESPMode::ThreadSafe>>();
+		if (solved->GetSeed() == layoutSeed)
 		{
-			// Ensure room used is likely to be unique
-			validRooms[0].Value++;
-			ShuffleArray<TRoomUses>(validRooms);
-			validRooms.Sort([](const TRoomUses& LHS, const TRoomUses& RHS) {return LHS.Value < RHS.Value; });
-			// Add the room to the position
-			FVector2D bresPos = FVector2D(x, y);
-			if ((AddRoom(bresPos, validRooms[0].Key)->GetClass() != StarterRoom.Get()))
-				for (int i = 0; i < 4; ++i) OpenConnectors.Add(TConPair((i + 3) % 4, bresPos));
-
-			// Algorithm-relevant
-			slopeError += mNew;
-			if (slopeError >= 0)
-			{
-				++y;
-				slopeError -= 2 * (x1 - x0);
-			}
+			Generation.Layout = *solved;
+			return;
 		}
+		UE_LOG(LogTemp, Display, TEXT("Prepared floor layout was for a different seed, solving again"));
 	}
 
-	FVector2D current;
+	FDungeonFloorLayoutSettings settings;
+	MakeLayoutSettings(settings);
+	Generation.Layout.Begin(settings, layoutSeed);
+}
+
+void ADungeonMacroGrid::MakeLayoutSettings(FDungeonFloorLayoutSettings& outSettings) const
+{
+	outSettings.Width = ArrayWidth;
+	outSettings.Height = ArrayHeight;
+	outSettings.StarterRoomPosition = StarterRoomPosition;
+	outSettings.EscapeRoomPosition = EscapeRoomPosition;
+	outSettings.StarterRoom = StarterRoom;
+	outSettings.TutorialRoom = TutorialRoom;
+	outSettings.MuralRoom = MuralRoom;
+	outSettings.EscapeRoom = EscapeRoom;
+	outSettings.MinFillChance = minFillChance;
+	outSettings.MaxFillChance = maxFillChance;
+	outSettings.FillChanceVelocity = fillChanceVelocity;
+	for (int i = 0; i < 4 && i < DirectionalBiases.Num(); ++i)
+		outSettings.DirectionalBiases[i] = DirectionalBiases[i];
+	outSettings.BuildRoomClasses(RoomList);
+}
+
+void ADungeonMacroGrid::PrepareNextFloorLayout(int32 nextFloorSeed)
+{
+	// Only one layout is kept ready at a time
+	if (NextLayout.IsValid())
+		return;
+
+	FDungeonFloorLayoutSettings settings;
+	MakeLayoutSettings(settings);
+	int32 seed = ADamnationGameModeBase::MakeStreamSeed(nextFloorSeed, EDungeonRandomStream::LAYOUT);
+	NextLayout = Async(EAsyncExecution::TaskGraph, [settings, seed]()
+	{
+		TSharedPtr<FDungeonFloorLayoutSolver, ESPMode::ThreadSafe> solver = MakeShared<FDungeonFloorLayoutSolver, ESPMode::ThreadSafe>();
+		solver->Begin(settings, seed);
+		solver->Solve();
+		return solver;
+	});
+}
 
-	while (OpenConnectors.Num() > 0)
+bool ADungeonMacroGrid::StepGenerationPhase()
+{
+	FFloorGenerationState& state = Generation;
+	const TArray<FVector2D>& order = state.Layout.GetOrder();
+	const bool bRoomsLeft = state.Cursor < order.Num();
+	switch (state.Phase)
 	{
-		int idx = FMath::RandRange(0, OpenConnectors.Num() - 1);
-		TConPair connector = OpenConnectors[idx];
-		FVector2D start = connector.Value;
-		current = jumpDirTable[connector.Key] + connector.Value;
-		auto room = GetRoom(current);
-		if (!IsValidSpace(current))
+	case EFloorGenerationPhase::LAYOUT:
+		if (state.Layout.Step())
+			return true;
+		// The fill chance keeps decaying across floors
+		maxFillChance = state.Layout.GetFillChance();
+		return false;
+	case EFloorGenerationPhase::ROOMSPAWN:
+		if (!bRoomsLeft)
+			return false;
+		SpawnRoom(order[state.Cursor], state.Layout.GetRoom(order[state.Cursor]));
+		++state.Cursor;
+		return true;
+	case EFloorGenerationPhase::TILESPAWN:
+		if (!bRoomsLeft)
+			return false;
+		GetRoom(order[state.Cursor])->LoadTextureToMap();
+		++state.Cursor;
+		return true;
+	case EFloorGenerationPhase::STITCHING:
+		if (!bRoomsLeft)
+			return false;
+		// Every room is in place, so only north & east are needed to connect each pair of rooms once
+		StitchRoom(GetRoom(order[state.Cursor]), order[state.Cursor], 0x3);
+		++state.Cursor;
+		return true;
+	case EFloorGenerationPhase::SIZING:
+		if (TileGraph.IsClearanceDirty())
 		{
-			UE_LOG(LogTemp, Error, TEXT("Connector leading to outside map boundaries; typically the result of the map being smaller than the mural/escape/start room positions. Increase map size or move the offending room."))
+			TileGraph.UpdateClearance(ClearanceTilesPerStep);
+			return true;
 		}
-		else if (!room)
+		// Rooms are finalized once every tile has its size
+		if (!bRoomsLeft)
+			return false;
+		GetRoom(order[state.Cursor])->OnMapFinalization();
+		++state.Cursor;
+		return true;
+	case EFloorGenerationPhase::EYEPLACEMENT:
+		if (!state.bGameSetup || state.Cursor > 0)
+			return false;
+		Gamemode->PlaceEyes(GetRoom(StarterRoomPosition + FVector2D(1, 0)));
+		++state.Cursor;
+		return true;
+	case EFloorGenerationPhase::MINIMAP:
+		if (!state.bGameSetup || state.Cursor > 0)
+			return false;
+		Gamemode->GenerateMinimap();
+		++state.Cursor;
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool ADungeonMacroGrid::StepFloorGeneration(float budgetMs)
+{
+	const double endTime = FPlatformTime::Seconds() + budgetMs / 1000.0;
+	while (IsGeneratingFloor())
+	{
+		if (!StepGenerationPhase())
 		{
-			// Tpair: Holds TConPair & float determining chance of connections in new room (0..1 range of probability)
-			TArray<TConPairChance, TFixedAllocator<4>> newConnectorChances;
-			// Check all adjacent rooms to the new room spot that aren't what we just came from
-			for (int i = 0; i < 4; ++i)
-			{
-				float chance;
-				FVector2D pos = jumpDirTable[i] + current;
-				// If it cannot support a tile, make it guaranteed failure
-				if (!IsValidSpace(pos)) chance = -1.0f;
-				// Original room must be connected, so ensure it with guaranteed chance
-				else if (pos == start) chance = 1.0f;
-				else
-				{
-					TConPair nextConnector(i, pos);
-					ADungeonRoomTileBase* nextRoom = GetRoom(pos);
-					if (nextRoom)
-					{
-						// If there is a connector in room to current, make it a guaranteed connector
-						// Else don't allow it to be a connector at all
-						chance = nextRoom->ValidCardinals[(i + 2) % 4] ? 1.0f : -1.0f;
-					}
-					// If there's no existing room but can support a tile, make it a random chance of being a connector accounting for bias
-					else
-					{
-						int relativeDir = ((i - connector.Key) + 4) % 4;
-
-						chance = GetFill() * DirectionalBiases[relativeDir];
-					}
-				}
-				newConnectorChances.Add(TConPairChance(TConPair(i, current), chance));
-			}
-			// Take chance array and make decisions on necessary connectors
-			TArray<bool, TFixedAllocator<4>> newConnectors;
-			newConnectors.Init(false, 4);
-			for (int i = 0; i < 4; ++i)
-			{
-				// Position that the new connector is leading to
-				FVector2D newConPos = FVector2D(newConnectorChances[i].Key.Value) + jumpDirTable[newConnectorChances[i].Key.Key];
-				// Potential connection chance
-				newConnectors[i] = newConnectorChances[i].Value >= FMath::FRand();
-			}
-			TArray<TRoomUses> validRooms;
-			validRooms.Empty(RoomList.Num());
-			// Find all rooms that meet the criteria in the room list
-			for (TRoomUses roomUses : RoomListUses)
-			{
-				bool roomValid = true;
-				for (int i = 0; i < 4; ++i)
-					if (newConnectors[i] != roomUses.Key.GetDefaultObject()->ValidCardinals[i])
-					{
-						roomValid = false;
-						break;
-					}
-				if (roomValid)
-					validRooms.Add(roomUses);
-			}
-			// Shuffle, then sort by use count
-			ShuffleArray<TRoomUses>(validRooms);
-			validRooms.Sort([](const TRoomUses& LHS, const TRoomUses& RHS) {return LHS.Value < RHS.Value; });
-			// Pick one of the rooms to place down, if any can be placed
-			if (validRooms.Num() > 0 && IsValidSpace(current))
-			{
-				auto roomType = validRooms[0].Key;
-				auto addedRoom = AddRoom(current, roomType);
-				// Increment uses on roomlist to make more unlikely to pick
-				int roomID = RoomListUses.Find(validRooms[0]);
-				RoomListUses[roomID].Value++;
-				// Add connectors of new room to list, except to previous room
-				for (int i = 0; i < 4; ++i)
-				{
-					if (jumpDirTable[i] + current == start)
-						continue;
-					if (addedRoom->ValidCardinals[i])
-						OpenConnectors.Add(TConPair(i, current));
-				}
-			}
+			// Phase finished, start the next
+			Generation.Phase = (EFloorGenerationPhase)((uint8)Generation.Phase + 1);
+			Generation.Cursor = 0;
 		}
-		// Remove the connector we just sorted out
-		OpenConnectors.RemoveAtSwap(idx, 1, false);
-		// Shuffle just for variation
-		// ShuffleArray<TConPair>(OpenConnectors);
+		if (budgetMs > 0.0f && FPlatformTime::Seconds() >= endTime)
+			break;
+	}
+	return Generation.Phase == EFloorGenerationPhase::COMPLETE;
+}
+
+float ADungeonMacroGrid::GetGenerationProgress() const
+{
+	const FFloorGenerationState& state = Generation;
+	if (state.Phase == EFloorGenerationPhase::IDLE)
+		return 0.0f;
+	if (state.Phase == EFloorGenerationPhase::COMPLETE)
+		return 1.0f;
+
+	// Each phase counts equally, progress within a phase is how many rooms it's been through
+	float phaseProgress = 0.0f;
+	const int32 roomCount = state.Layout.GetOrder().Num();
+	if (state.Phase == EFloorGenerationPhase::LAYOUT)
+		phaseProgress = (float)roomCount / FMath::Max(roomCount + state.Layout.GetOpenConnectorCount(), 1);
+	else if (roomCount > 0)
+		phaseProgress = (float)state.Cursor / roomCount;
+	const float phaseCount = (float)EFloorGenerationPhase::COMPLETE - 1;
+	return FMath::Clamp(((float)state.Phase - 1 + phaseProgress) / phaseCount, 0.0f, 1.0f);
+}
+
+void ADungeonMacroGrid::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	bool bComplete = StepFloorGeneration(GenerationBudgetMs);
+	if (UDungeonGameInstanceBase* gameInstance = Cast<UDungeonGameInstanceBase>(GetGameInstance()))
+		gameInstance->SetGenerationProgress(GetGenerationProgress());
+	if (bComplete || !IsGeneratingFloor())
+	{
+		SetActorTickEnabled(false);
+		if (bComplete)
+			OnFloorGenerated.Broadcast();
 	}
-	// DEBUG_GenerateNoiseMap();
 }
 
 void ADungeonMacroGrid::DestroyGeneration()
 {
+	// Destroy eyes, before their tiles are reset
+	for (auto eyeTile : Gamemode->ActiveEyeTiles)
+		eyeTile->OccupyingActor->Destroy();
+	Gamemode->ActiveEyeTiles.Empty(6);
+	Gamemode->EyeSpawns.Empty(6);
+
 	for (int i = 0; i < RoomGridFlatArray.Num(); ++i)
 	{
 		auto room = RoomGridFlatArray[i];
-		if (room)
+		if (room && room->bPoolable)
+		{
+			room->ResetRoom();
+			ActorPool.Release(room);
+		}
+		else if (room)
 			room->DestroyRoom();
 		RoomGridFlatArray[i] = nullptr;
 	}
+	OccupiedRooms.Reset();
+	// Stop any generation in progress from spawning into the wiped floor
+	Generation = FFloorGenerationState();
+	SetActorTickEnabled(false);
+	// Outstanding searches refer to tiles that are about to be destroyed
+	AsyncPathfinder.CancelAll();
+	TileGraph.Reset();
+	RoomGraph.Reset();
+	SightMap.Reset();
+	PathCache.Reset();
 
 
-	// Destroy eyes
-	for (auto eyeTile : Gamemode->ActiveEyeTiles)
-		eyeTile->OccupyingActor->Destroy();
-	Gamemode->ActiveEyeTiles.Empty(6);
-	Gamemode->EyeSpawns.Empty(6);
-
 	// Reverse-iterate destruction list to avoid alloc errors
 	for (int i = DestructionList.Num() - 1; i >= 0; --i)
 		DestructionList[i]->Destroy();
 	DestructionList.Empty();
+
+	ActorPool.LogStats();
 }
 
 void ADungeonMacroGrid::GenerateBossRoom()
@@ -8,8 +8,34 @@
 #include "Kismet/KismetArrayLibrary.h"
 #include "DungeonRoomTileBase.h"
 #include "DungeonEye.h"
+#include "DungeonPathfinding.h"
+#include "DungeonRoomGraph.h"
+#include "DungeonAsyncPathfinding.h"
+#include "DungeonPathCache.h"
+#include "DungeonFloorLayout.h"
+#include "DungeonActorPool.h"
+#include "DungeonSightMap.h"
+#include "Async/Async.h"
+#include "HAL/ThreadSafeCounter.h"
 #include "DungeonMacroGrid.generated.h"
 
+// The stages of floor generation, in order.
+UENUM(BlueprintType)
+enum class EFloorGenerationPhase : uint8
+{
+	IDLE = 0 UMETA(DisplayName = "Idle"),
+	LAYOUT = 1 UMETA(DisplayName = "Layout"),
+	ROOMSPAWN = 2 UMETA(DisplayName = "Room Spawn"),
+	TILESPAWN = 3 UMETA(DisplayName = "Tile Spawn"),
+	STITCHING = 4 UMETA(DisplayName = "Connection Stitching"),
+	SIZING = 5 UMETA(DisplayName = "Tile Sizing"),
+	EYEPLACEMENT = 6 UMETA(DisplayName = "Eye Placement"),
+	MINIMAP = 7 UMETA(DisplayName = "Minimap"),
+	COMPLETE = 8 UMETA(DisplayName = "Complete")
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FFloorGeneratedSignature);
+
 UCLASS()
 class DAMNATION_API ADungeonMacroGrid : public AActor
 {
@@ -19,6 +45,9 @@ public:
 	// Sets default values for this actor's properties
 	ADungeonMacroGrid();
 
+	// Called every frame while generating a floor with GenerateFloorTimeSliced
+	virtual void Tick(float DeltaTime) override;
+
 	UFUNCTION(BlueprintCallable)
 	void SetGamemode(ADamnationGameModeBase* gm) { Gamemode = gm; }
 	UFUNCTION(BlueprintPure)
@@ -55,6 +84,99 @@ public:
 	UFUNCTION(BlueprintCallable)
 	TArray<ADungeonSingleTile*> GeneratePath(ADungeonSingleTile* start, ADungeonSingleTile* end, int actorSize = 1, bool getClosest = true, bool respectOccupants = false);
 
+	// Finds a path between tile indices using the supplied search context as scratch space, filling outPath with tile indices.
+	// Never spawns proxies or changes the grid, so may run on any thread provided each call uses its own context & the floor
+	// isn't changed meanwhile. Call UpdateRoomGraph on the game thread first or the room graph is skipped, and convert the
+	// result with GetTileGraph().ToTiles back on the game thread since that can spawn proxies.
+	bool GeneratePath(FDungeonPathContext& context, int32 start, int32 end, TArray<int32>& outPath, int actorSize = 1, bool getClosest = true, bool respectOccupants = false) const;
+
+	// Queues a path search on a worker thread against a snapshot of the floor. onComplete is called on the game thread.
+	// Returns an invalid handle if either tile isn't on this grid.
+	FDungeonAsyncPathHandle GeneratePathAsync(ADungeonSingleTile* start, ADungeonSingleTile* end, int actorSize = 1, bool getClosest = true, bool respectOccupants = false, FDungeonAsyncPathfinder::FOnComplete onComplete = nullptr);
+
+	// Cancels a path search queued by GeneratePathAsync. Returns false if it had already finished.
+	bool CancelPathAsync(int32 requestId) { return AsyncPathfinder.Cancel(requestId); }
+
+	// Path cache statistics, for tuning PathCacheSize
+	UFUNCTION(BlueprintPure, Category = "Pathfinding")
+	int32 GetPathCacheHits() const { return PathCache.GetHits(); }
+	UFUNCTION(BlueprintPure, Category = "Pathfinding")
+	int32 GetPathCacheMisses() const { return PathCache.GetMisses(); }
+	UFUNCTION(BlueprintCallable, Category = "Pathfinding")
+	void ResetPathCacheStats() { PathCache.ResetStats(); }
+
+	// Nodes expanded by every GeneratePath search so far, for benchmarking.
+	uint64 GetPathExpandedCount() { return PathContexts.GetExpandedCount(); }
+
+	// Search contexts for the GeneratePath overload taking one, so concurrent callers' searches are counted with the rest.
+	FDungeonPathContextPool& GetPathContexts() { return PathContexts; }
+
+	// Paths & routes requested so far, including async & cached requests.
+	uint32 GetPathRequestCount() const { return (uint32)PathRequestCount.GetValue(); }
+
+	// Plans a room-level route for refining a room at a time with RefineRoute. Returns false if a flat path should be used instead.
+	bool GenerateRoute(ADungeonSingleTile* start, ADungeonSingleTile* end, int actorSize, FDungeonRoomRoute& outRoute);
+
+	// Appends the tiles of the routes' next segment to outPath. Returns false if the segment is no longer walkable.
+	bool RefineRoute(FDungeonRoomRoute& route, TArray<ADungeonSingleTile*>& outPath) const;
+
+	// Brings the room portal graph up to date with any tile graph changes. Called automatically by GeneratePath & GenerateRoute.
+	void UpdateRoomGraph()
+	{
+		TileGraph.UpdateClearance();
+		RoomGraph.Update(TileGraph);
+	}
+
+	// Recomputes the available space of tiles changed since the last update. Returns the number of tiles whose space changed.
+	int32 UpdateClearance();
+
+	// Adds a tile at location to the floor & returns its compact index. Called by rooms as tiles are added.
+	// room is the rooms' flat index on this grid & localIndex the tiles' flat index in that room.
+	// No actor is spawned, see GetTileProxy.
+	int32 RegisterTile(const FVector& location, int32 room = INDEX_NONE, int32 localIndex = INDEX_NONE);
+
+	// Connects tiles a & b both ways, keeping any spawned proxies' connections in sync.
+	void LinkTiles(int32 a, ECardinal aToB, int32 b, ECardinal bToA);
+
+	// Gets the proxy actor for a tile, taking one from the pool the first time the tile is asked for.
+	ADungeonSingleTile* GetTileProxy(int32 index);
+
+	// Takes a tile from the pool, or spawns one, at location.
+	ADungeonSingleTile* AcquireTile(const FVector& location);
+
+	// Resets tile & returns it to the pool. The tile graph isn't updated, so only use when the whole floor is going.
+	void ReleaseTile(ADungeonSingleTile* tile);
+
+	// Logs how many tiles & rooms have been spawned & reused, & the most in use at once.
+	void LogActorPoolStats() const { ActorPool.LogStats(); }
+
+	UFUNCTION(BlueprintPure, Category = "Map Generation")
+	int32 GetTilePoolHighWaterMark() const { return ActorPool.GetStats(ADungeonSingleTile::StaticClass()).HighWater; }
+
+	// Gets a tile by its compact floor index, spawning its proxy if needed.
+	ADungeonSingleTile* GetTileByTileIndex(int32 index) const { return TileGraph.GetTile(index); }
+
+	// Logs the memory used by the tile graph & by the spawned proxy actors, & how many actors are in the world.
+	void LogTileMemory() const;
+
+	int32 GetTileCount() const { return TileGraph.Num(); }
+
+	// The flat movement graph of every tile on the floor.
+	const FDungeonTileGraph& GetTileGraph() const { return TileGraph; }
+
+	// Whether no wall lies between the centres of two tiles. Answered from the tile grid, without a physics trace.
+	UFUNCTION(BlueprintPure, Category = "Sight")
+	bool HasLineOfSight(ADungeonSingleTile* from, ADungeonSingleTile* to) const;
+
+	// Every tile within radius tiles of origin that it has line of sight to, including origin.
+	// Spawns the proxy of every visible tile; native code should use GetSightMap, which works on tile indices.
+	UFUNCTION(BlueprintCallable, Category = "Sight")
+	TArray<ADungeonSingleTile*> GetVisibleTiles(ADungeonSingleTile* origin, int radius);
+
+	// Tile-space walls for sight queries, shared by everything that needs to know what can see what.
+	FDungeonSightMap& GetSightMap() { return SightMap; }
+	const FDungeonSightMap& GetSightMap() const { return SightMap; }
+
 	UFUNCTION(BlueprintPure)
 	FVector2D FlatToGridIndex(int index);
 	UFUNCTION(BlueprintPure)
@@ -72,6 +194,38 @@ public:
 	// Generates dungeon floor map
 	void GenerateFloor();
 
+	// Generates the floor over as many frames as needed, spending up to GenerationBudgetMs each frame.
+	// Also places the eyes & generates the minimap, then calls OnFloorGenerated.
+	UFUNCTION(BlueprintCallable)
+	void GenerateFloorTimeSliced();
+
+	// Runs floor generation until it completes or budgetMs has passed; no limit if budgetMs <= 0.
+	// Returns true once complete. Requires a generation to have been started.
+	bool StepFloorGeneration(float budgetMs);
+
+	// Starts solving the next floors' layout on a worker thread, to be used by the next GenerateFloor or GenerateFloorTimeSliced.
+	// nextFloorSeed is the seed the next floor will be given, see ADamnationGameModeBase::SeedFloor; if it turns out different
+	// the layout is thrown away & solved again. Settings are read now, so changes made afterwards only apply from the floor after.
+	UFUNCTION(BlueprintCallable)
+	void PrepareNextFloorLayout(int32 nextFloorSeed);
+
+	UFUNCTION(BlueprintPure)
+	bool IsNextFloorLayoutReady() const { return NextLayout.IsValid() && NextLayout.IsReady(); }
+
+	UFUNCTION(BlueprintPure)
+	bool IsGeneratingFloor() const { return Generation.Phase != EFloorGenerationPhase::IDLE && Generation.Phase != EFloorGenerationPhase::COMPLETE; }
+
+	UFUNCTION(BlueprintPure)
+	EFloorGenerationPhase GetGenerationPhase() const { return Generation.Phase; }
+
+	// Rough progress through floor generation, 0..1.
+	UFUNCTION(BlueprintPure)
+	float GetGenerationProgress() const;
+
+	// Called once a floor started by GenerateFloorTimeSliced is complete.
+	UPROPERTY(BlueprintAssignable)
+	FFloorGeneratedSignature OnFloorGenerated;
+
 	// Completely wipes the dungeon and all related objects. Designed specifically for demo purposes.
 	UFUNCTION(BlueprintCallable)
 	void DestroyGeneration();
@@ -95,6 +249,14 @@ public:
 	UPROPERTY(EditAnywhere, Category = "Map Generation")
 	FVector2D EscapeRoomPosition = FVector2D(10, 7);
 
+	// The time GenerateFloorTimeSliced may spend generating each frame, in milliseconds.
+	UPROPERTY(EditAnywhere, Category = "Map Generation")
+	float GenerationBudgetMs = 8.0f;
+
+	// The number of paths GeneratePath remembers. Paths are forgotten whenever the floor changes.
+	UPROPERTY(EditAnywhere, Category = "Pathfinding")
+	int PathCacheSize = 64;
+
 	// The minimum chance for a random-chance connector to be valid
 	UPROPERTY(EditAnywhere, Category = "Map Generation|Fill Values")
 	float minFillChance = 0.1f;
@@ -138,8 +300,6 @@ public:
 	UPROPERTY(BlueprintReadWrite)
 	TArray<AActor*> DestructionList;
 
-	// Get fill chance & modify by velocity
-	float GetFill();
 
 	// Map of colours on map to spawns
 	// TMap<FColor, FTileColorSpawn> ColorItemMap;
@@ -159,6 +319,73 @@ protected:
 	UPROPERTY()
 	TArray<ADungeonRoomTileBase*> RoomGridFlatArray;
 
+	// Flat index of every room on the grid, for picking random rooms
+	TArray<int32> OccupiedRooms;
+
+	// Every tile on the floor, indexed by ADungeonSingleTile::TileIndex
+	FDungeonTileGraph TileGraph;
+
+	// Room-level portal graph for long queries
+	FDungeonRoomGraph RoomGraph;
+
+	// Which cells of the floor hold tiles, for line of sight
+	FDungeonSightMap SightMap;
+
+	// Scratch space for pathfinding queries
+	FDungeonPathContextPool PathContexts;
+
+	// Results of recent GeneratePath calls
+	FDungeonPathCache PathCache;
+
+	// Counted from every thread searching the floor
+	mutable FThreadSafeCounter PathRequestCount;
+
+	// Worker thread path searches
+	FDungeonAsyncPathfinder AsyncPathfinder;
+
+	// Tiles & poolable rooms kept between floors
+	FDungeonActorPool ActorPool;
+
+	// Where floor generation is up to, so it can be resumed on a later frame
+	struct FFloorGenerationState
+	{
+		EFloorGenerationPhase Phase = EFloorGenerationPhase::IDLE;
+		// Whether eye placement & the minimap are part of this generation
+		bool bGameSetup = false;
+		// The room class decided for each grid position
+		FDungeonFloorLayoutSolver Layout;
+		// Progress through the planned rooms in the current phase
+		int32 Cursor = 0;
+	};
+	FFloorGenerationState Generation;
+
+	// A layout being solved in the background for the next floor
+	TFuture<TSharedPtr<FDungeonFloorLayoutSolver, ESPMode::ThreadSafe>> NextLayout;
+
+	// Room choices outside of generation, split from the floor seed
+	FRandomStream Random;
+
+	// Resets the generation state & starts the layout, taking over the one from PrepareNextFloorLayout if it has the right seed.
+	void BeginFloorGeneration(bool bGameSetup);
+
+	// Copies the grids' generation settings for the layout solver.
+	void MakeLayoutSettings(FDungeonFloorLayoutSettings& outSettings) const;
+
+	// Performs a single unit of work in the current phase. Returns false once the phase has nothing left to do.
+	bool StepGenerationPhase();
+
+	// Spawns a room without loading its map or connecting it.
+	ADungeonRoomTileBase* SpawnRoom(FVector2D position, TSubclassOf<ADungeonRoomTileBase> roomType);
+
+	// Connects a rooms' edge tiles to the rooms next to it. directions is a mask of the cardinals to check (bit n == cardinal n).
+	void StitchRoom(ADungeonRoomTileBase* room, FVector2D position, uint8 directions = 0xF);
+
+	// Searches through the room graph where possible, otherwise the flat graph.
+	bool FindPath(FDungeonPathContext& context, const FDungeonPathQuery& query, TArray<int32>& outPath) const;
+
+	// Fills outQuery for a search between two tile indices. Returns false if either tile isn't on this grid.
+	bool MakePathQuery(int32 start, int32 end, int actorSize, bool getClosest, bool respectOccupants, FDungeonPathQuery& outQuery) const;
+
 	int ArrayWidth = 0;
 	int ArrayHeight = 0;
 	int FlatArraySize = 0;
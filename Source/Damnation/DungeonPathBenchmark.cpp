@@ -0,0 +1,196 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DungeonPathBenchmark.h"
+#include "DungeonMacroGrid.h"
+#include "DungeonJumpPointSearch.h"
+#include "HAL/MemoryBase.h"
+#include "HAL/ThreadSafeCounter64.h"
+
+namespace
+{
+	// Forwards to the real allocator, counting every allocation made through it
+	class FCountingMalloc : public FMalloc
+	{
+	public:
+		explicit FCountingMalloc(FMalloc* inner) : Inner(inner) {}
+
+		virtual void* Malloc(SIZE_T count, uint32 alignment) override
+		{
+			Allocations.Increment();
+			return Inner->Malloc(count, alignment);
+		}
+
+		virtual void* Realloc(void* original, SIZE_T count, uint32 alignment) override
+		{
+			// Growing an existing allocation counts, as it may move
+			if (count > 0)
+				Allocations.Increment();
+			return Inner->Realloc(original, count, alignment);
+		}
+
+		virtual void Free(void* original) override { Inner->Free(original); }
+		virtual bool GetAllocationSize(void* original, SIZE_T& outSize) override { return Inner->GetAllocationSize(original, outSize); }
+		virtual SIZE_T QuantizeSize(SIZE_T count, uint32 alignment) override { return Inner->QuantizeSize(count, alignment); }
+		virtual bool IsInternallyThreadSafe() const override { return Inner->IsInternallyThreadSafe(); }
+		virtual const TCHAR* GetDescriptiveName() override { return TEXT("DungeonPathBenchmark"); }
+
+		int64 GetAllocations() const { return Allocations.GetValue(); }
+
+	private:
+		FMalloc* Inner;
+		FThreadSafeCounter64 Allocations;
+	};
+
+	// Fills in results' times from the time of each query, sorting times.
+	void SummariseTimes(TArray<double>& times, FDungeonPathBenchmarkResult& result)
+	{
+		times.Sort();
+		result.QueryCount = times.Num();
+		for (double time : times)
+			result.TotalMs += time;
+		result.AverageMs = result.TotalMs / times.Num();
+		result.MinMs = times[0];
+		result.MaxMs = times.Last();
+		result.P50Ms = times[(times.Num() - 1) / 2];
+		result.P99Ms = times[FMath::Min(times.Num() - 1, (times.Num() * 99) / 100)];
+	}
+}
+
+FDungeonPathBenchmarkResult FDungeonPathBenchmark::Run(ADungeonMacroGrid* grid, int32 queryCount, int actorSize, bool respectOccupants, bool bCountAllocations)
+{
+	FDungeonPathBenchmarkResult result;
+	if (!grid || queryCount <= 0)
+		return result;
+
+	TArray<double> times;
+	times.Reserve(queryCount);
+	uint64 startExpanded = grid->GetPathExpandedCount();
+	FCountingMalloc countingMalloc(GMalloc);
+
+	for (int32 i = 0; i < queryCount; ++i)
+	{
+		ADungeonRoomTileBase* startRoom = grid->GetRoomRandom();
+		ADungeonRoomTileBase* endRoom = grid->GetRoomRandom();
+		ADungeonSingleTile* start = startRoom ? startRoom->GetTileRandom(actorSize) : nullptr;
+		ADungeonSingleTile* end = endRoom ? endRoom->GetTileRandom(actorSize) : nullptr;
+		if (!start || !end)
+			continue;
+
+		// Only the path generation itself is timed, random tile selection is excluded.
+		// The counter forwards to the real allocator, so the path can be freed once it has been swapped back.
+		FMalloc* previousMalloc = GMalloc;
+		if (bCountAllocations)
+			GMalloc = &countingMalloc;
+		uint64 startCycles = FPlatformTime::Cycles64();
+		TArray<ADungeonSingleTile*> path = grid->GeneratePath(start, end, actorSize, true, respectOccupants);
+		times.Add(FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - startCycles));
+		GMalloc = previousMalloc;
+	}
+
+	if (times.Num() == 0)
+		return result;
+
+	SummariseTimes(times, result);
+	result.AverageExpanded = (double)(grid->GetPathExpandedCount() - startExpanded) / times.Num();
+	result.AverageAllocations = (double)countingMalloc.GetAllocations() / times.Num();
+	return result;
+}
+
+FDungeonSolverComparison FDungeonPathBenchmark::CompareSolvers(const FDungeonTileGraph& graph, int32 queryCount, int32 seed)
+{
+	FDungeonSolverComparison comparison;
+	TArray<int32> tiles;
+	for (int32 i = 0; i < graph.Num(); ++i)
+		if (graph.GetAvailableSpace(i) >= 1 && !graph.IsPathingIgnored(i))
+			tiles.Add(i);
+	if (tiles.Num() < 2 || queryCount <= 0)
+		return comparison;
+
+	FRandomStream stream(seed);
+	FDungeonPathContext context;
+	FDungeonPathQuery query;
+	query.bGetClosest = false;
+	query.bRespectOccupants = false;
+	TArray<double> aStarTimes;
+	TArray<double> jumpPointTimes;
+	aStarTimes.Reserve(queryCount);
+	jumpPointTimes.Reserve(queryCount);
+	uint64 aStarExpanded = 0;
+	uint64 jumpPointExpanded = 0;
+	TArray<int32> aStarPath;
+	TArray<int32> jumpPointPath;
+
+	for (int32 i = 0; i < queryCount; ++i)
+	{
+		query.Start = tiles[stream.RandHelper(tiles.Num())];
+		query.End = tiles[stream.RandHelper(tiles.Num())];
+		if (query.Start == query.End)
+			continue;
+
+		uint64 startExpanded = context.GetExpandedCount();
+		uint64 startCycles = FPlatformTime::Cycles64();
+		bool aStarFound = FDungeonPathfinder::FindPath(graph, context, query, aStarPath);
+		aStarTimes.Add(FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - startCycles));
+		aStarExpanded += context.GetExpandedCount() - startExpanded;
+
+		startExpanded = context.GetExpandedCount();
+		startCycles = FPlatformTime::Cycles64();
+		bool jumpPointFound = FDungeonJumpPointSearch::FindPath(graph, context, query, jumpPointPath);
+		jumpPointTimes.Add(FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - startCycles));
+		jumpPointExpanded += context.GetExpandedCount() - startExpanded;
+
+		if (aStarFound != jumpPointFound || jumpPointPath.Num() > aStarPath.Num())
+			++comparison.Mismatches;
+	}
+
+	if (aStarTimes.Num() == 0)
+		return comparison;
+
+	SummariseTimes(aStarTimes, comparison.AStar);
+	comparison.AStar.AverageExpanded = (double)aStarExpanded / comparison.AStar.QueryCount;
+	SummariseTimes(jumpPointTimes, comparison.JumpPoint);
+	comparison.JumpPoint.AverageExpanded = (double)jumpPointExpanded / comparison.JumpPoint.QueryCount;
+	return comparison;
+}
+
+void FDungeonPathBenchmark::BuildArena(FDungeonTileGraph& graph, int32 width, int32 height)
+{
+	const float separation = ADungeonRoomTileBase::TileSeparation;
+	for (int32 y = 0; y < height; ++y)
+		for (int32 x = 0; x < width; ++x)
+			graph.AddTile(nullptr, FVector(x * separation, y * separation, 0.0f));
+
+	// Laid out row by row, so the tile at (x, y) is y * width + x
+	for (int32 y = 0; y < height; ++y)
+	{
+		for (int32 x = 0; x < width; ++x)
+		{
+			int32 tile = y * width + x;
+			if (x + 1 < width)
+			{
+				graph.SetConnection(tile, (int32)ECardinal::EAST, tile + 1);
+				graph.SetConnection(tile + 1, (int32)ECardinal::WEST, tile);
+			}
+			if (y + 1 < height)
+			{
+				graph.SetConnection(tile, (int32)ECardinal::NORTH, tile + width);
+				graph.SetConnection(tile + width, (int32)ECardinal::SOUTH, tile);
+			}
+		}
+	}
+	graph.UpdateClearance();
+}
+
+void FDungeonPathBenchmark::LogResult(const FString& label, const FDungeonPathBenchmarkResult& result)
+{
+	UE_LOG(LogTemp, Display, TEXT("%s: %d queries, total %.3fms, avg %.4fms, min %.4fms, p50 %.4fms, p99 %.4fms, max %.4fms, %.1f expanded/query, %.2f allocations/query"),
+		*label, result.QueryCount, result.TotalMs, result.AverageMs, result.MinMs, result.P50Ms, result.P99Ms, result.MaxMs, result.AverageExpanded, result.AverageAllocations);
+}
+
+void FDungeonPathBenchmark::LogComparison(const FString& label, const FDungeonSolverComparison& comparison)
+{
+	LogResult(label + TEXT(", A*"), comparison.AStar);
+	LogResult(label + TEXT(", jump point search"), comparison.JumpPoint);
+	if (comparison.Mismatches > 0)
+		UE_LOG(LogTemp, Warning, TEXT("%s: jump point search disagreed with A* on %d queries"), *label, comparison.Mismatches);
+}
@@ -0,0 +1,62 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class ADungeonMacroGrid;
+struct FDungeonTileGraph;
+
+// Timing results for a batch of pathfinding queries, in milliseconds.
+struct DAMNATION_API FDungeonPathBenchmarkResult
+{
+	int32 QueryCount = 0;
+	double TotalMs = 0.0;
+	double AverageMs = 0.0;
+	double MinMs = 0.0;
+	double MaxMs = 0.0;
+	double P50Ms = 0.0;
+	double P99Ms = 0.0;
+	// Open list pops per query
+	double AverageExpanded = 0.0;
+	// Heap allocations per query, only counted when run with bCountAllocations
+	double AverageAllocations = 0.0;
+};
+
+// A* & jump point search answering the same queries, see FDungeonPathBenchmark::CompareSolvers.
+struct DAMNATION_API FDungeonSolverComparison
+{
+	FDungeonPathBenchmarkResult AStar;
+	FDungeonPathBenchmarkResult JumpPoint;
+	// Queries where only one solver found a path, or jump point search's path was longer.
+	// Jump point search always finds the fewest steps, so this should be 0.
+	int32 Mismatches = 0;
+};
+
+/*
+* Fires random start/goal queries at ADungeonMacroGrid::GeneratePath on the currently generated floor & times each one.
+* Only uses the public GeneratePath interface, so the same run can be repeated on an older build for a before/after comparison.
+*/
+struct DAMNATION_API FDungeonPathBenchmark
+{
+	/*
+	* bCountAllocations swaps GMalloc for a counting wrapper around each query. Allocations made by other threads
+	* during a query are counted too, so only use it when nothing else is running, e.g. from the benchmark commandlet.
+	*/
+	static FDungeonPathBenchmarkResult Run(ADungeonMacroGrid* grid, int32 queryCount, int actorSize = 1, bool respectOccupants = false, bool bCountAllocations = false);
+
+	/*
+	* Runs the same random unweighted queries through A* & jump point search directly on graph, skipping the room graph & path cache
+	* GeneratePath tries first, so the solvers' expansions can be compared. The graphs' clearance must be up to date.
+	*/
+	static FDungeonSolverComparison CompareSolvers(const FDungeonTileGraph& graph, int32 queryCount, int32 seed);
+
+	// Fills an empty graph with an open width x height arena, every tile linked to its neighbours.
+	static void BuildArena(FDungeonTileGraph& graph, int32 width, int32 height);
+
+	// Writes the result to the log under the supplied label.
+	static void LogResult(const FString& label, const FDungeonPathBenchmarkResult& result);
+
+	// Writes both solvers' results & the mismatch count to the log under the supplied label.
+	static void LogComparison(const FString& label, const FDungeonSolverComparison& comparison);
+};
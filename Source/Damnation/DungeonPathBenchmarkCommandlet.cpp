@@ -0,0 +1,206 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DungeonPathBenchmarkCommandlet.h"
+#include "DungeonPathBenchmark.h"
+#include "DamnationGameModeBase.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "Misc/FileHelper.h"
+#include "Kismet/GameplayStatics.h"
+
+namespace
+{
+	struct FMapSize
+	{
+		int32 Width;
+		int32 Height;
+	};
+
+	// Parses "WxH,WxH..." into map sizes, skipping malformed entries.
+	void ParseSizes(const FString& sizeList, TArray<FMapSize>& outSizes)
+	{
+		TArray<FString> entries;
+		sizeList.ParseIntoArray(entries, TEXT(","));
+		for (const FString& entry : entries)
+		{
+			FString width, height;
+			if (entry.Split(TEXT("x"), &width, &height) && FCString::Atoi(*width) > 0 && FCString::Atoi(*height) > 0)
+				outSizes.Add({ FCString::Atoi(*width), FCString::Atoi(*height) });
+			else
+				UE_LOG(LogTemp, Warning, TEXT("DungeonPathBenchmark: ignoring malformed size '%s', expected WIDTHxHEIGHT"), *entry);
+		}
+	}
+
+	// Spawns the game mode, player & grid & generates a floor, the same as InitDungeonMap minus the minimap, eyes & BeginGame.
+	// outGenerationMs is the time taken by GenerateFloor alone.
+	ADungeonMacroGrid* GenerateFloor(UWorld* world, UClass* gameModeClass, UClass* gridClass, const FMapSize& size, int32 seed, bool bNativeColors, double& outGenerationMs)
+	{
+		FActorSpawnParameters spawnParams;
+		spawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		ADamnationGameModeBase* gameMode = world->SpawnActor<ADamnationGameModeBase>(gameModeClass, spawnParams);
+		if (!gameMode)
+			return nullptr;
+		// -DungeonSeed= still takes priority
+		gameMode->FixedFloorSeed = seed;
+		// Colour events for the player spawn expect a player to exist
+		gameMode->ActivePlayer = world->SpawnActor<ADungeonCrawlerPlayer>(gameMode->PlayerActorType, spawnParams);
+		if (gameMode->ActivePlayer)
+			gameMode->ActivePlayer->SetGamemode(gameMode);
+		gameMode->SeedFloor();
+		gameMode->BindColorMapEvents();
+		// Every colour goes through its Blueprint delegate, as before native colour actions
+		if (!bNativeColors)
+			gameMode->NativeColorMap.Empty();
+
+		// Map size is read in PostInitializeComponents, so must be set before spawning finishes
+		ADungeonMacroGrid* grid = world->SpawnActorDeferred<ADungeonMacroGrid>(gridClass, FTransform::Identity, nullptr, nullptr, ESpawnActorCollisionHandlingMethod::AlwaysSpawn);
+		grid->MapMaxWidth = size.Width;
+		grid->MapMaxHeight = size.Height;
+		UGameplayStatics::FinishSpawningActor(grid, FTransform::Identity);
+
+		gameMode->DungeonMap = grid;
+		grid->SetGamemode(gameMode);
+		double startTime = FPlatformTime::Seconds();
+		grid->GenerateFloor();
+		outGenerationMs = (FPlatformTime::Seconds() - startTime) * 1000.0;
+		return grid;
+	}
+}
+
+UDungeonPathBenchmarkCommandlet::UDungeonPathBenchmarkCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 UDungeonPathBenchmarkCommandlet::Main(const FString& Params)
+{
+	FString sizeList = TEXT("15x11,20x20,30x30");
+	int32 queryCount = 2000;
+	int32 seed = 1;
+	FString gridPath = TEXT("/Game/DemoMacroGrid.DemoMacroGrid_C");
+	FString gameModePath = TEXT("/Game/Blueprints/DungeonGamemode.DungeonGamemode_C");
+	FString csvPath;
+	bool bNativeColors = true;
+	int32 regenerationCount = 0;
+	int32 arenaSize = 75;
+	FParse::Value(*Params, TEXT("Sizes="), sizeList);
+	FParse::Value(*Params, TEXT("Queries="), queryCount);
+	FParse::Value(*Params, TEXT("Seed="), seed);
+	FParse::Value(*Params, TEXT("Grid="), gridPath);
+	FParse::Value(*Params, TEXT("GameMode="), gameModePath);
+	FParse::Value(*Params, TEXT("Csv="), csvPath);
+	FParse::Bool(*Params, TEXT("NativeColors="), bNativeColors);
+	FParse::Value(*Params, TEXT("Regenerations="), regenerationCount);
+	FParse::Value(*Params, TEXT("Arena="), arenaSize);
+
+	UClass* gridClass = LoadClass<ADungeonMacroGrid>(nullptr, *gridPath);
+	UClass* gameModeClass = LoadClass<ADamnationGameModeBase>(nullptr, *gameModePath);
+	if (!gridClass || !gameModeClass)
+	{
+		UE_LOG(LogTemp, Error, TEXT("DungeonPathBenchmark: couldn't load grid class '%s' or game mode class '%s'"), *gridPath, *gameModePath);
+		return 1;
+	}
+
+	TArray<FMapSize> sizes;
+	ParseSizes(sizeList, sizes);
+
+	// Fixed rooms must be on the grid, see ADungeonMacroGrid::IsValidSpace
+	const ADungeonMacroGrid* gridDefaults = gridClass->GetDefaultObject<ADungeonMacroGrid>();
+	// The tutorial room is placed one past the starter room
+	const int32 minHeight = (int32)FMath::Max(gridDefaults->StarterRoomPosition.X + 1, gridDefaults->EscapeRoomPosition.X) + 1;
+	const int32 minWidth = (int32)FMath::Max(gridDefaults->StarterRoomPosition.Y, gridDefaults->EscapeRoomPosition.Y) + 1;
+
+	FString csv = TEXT("Width,Height,Tiles,GenerationMs,ActorSize,RespectOccupants,Queries,AverageMs,P50Ms,P99Ms,MaxMs,ExpandedPerQuery,AllocationsPerQuery\n");
+	for (const FMapSize& size : sizes)
+	{
+		if (size.Width < minWidth || size.Height < minHeight)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("DungeonPathBenchmark: skipping %dx%d, the grids' fixed rooms need at least %dx%d"), size.Width, size.Height, minWidth, minHeight);
+			continue;
+		}
+
+		// Fresh world per size so nothing from the previous floor is left behind
+		UWorld* world = UWorld::CreateWorld(EWorldType::Game, false, TEXT("DungeonPathBenchmark"));
+		FWorldContext& worldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+		worldContext.SetCurrentWorld(world);
+		// Rooms & tiles spawn through GWorld
+		UWorld* previousWorld = GWorld;
+		GWorld = world;
+		world->InitializeActorsForPlay(FURL());
+
+		FMath::RandInit(seed);
+		FMath::SRandInit(seed);
+		double generationMs = 0.0;
+		ADungeonMacroGrid* grid = GenerateFloor(world, gameModeClass, gridClass, size, seed, bNativeColors, generationMs);
+		if (grid)
+		{
+			UE_LOG(LogTemp, Display, TEXT("DungeonPathBenchmark: generated %dx%d floor (%d tiles) in %.3fms%s"), size.Width, size.Height, grid->GetTileCount(),
+				generationMs, bNativeColors ? TEXT("") : TEXT(" without native colour actions"));
+			grid->LogTileMemory();
+			for (int actorSize : { 1, 3 })
+			{
+				for (bool respectOccupants : { false, true })
+				{
+					FDungeonPathBenchmarkResult result = FDungeonPathBenchmark::Run(grid, queryCount, actorSize, respectOccupants, true);
+					FString label = FString::Printf(TEXT("%dx%d floor (%d tiles), size %d%s"), size.Width, size.Height, grid->GetTileCount(),
+						actorSize, respectOccupants ? TEXT(", respecting occupants") : TEXT(""));
+					FDungeonPathBenchmark::LogResult(label, result);
+					csv += FString::Printf(TEXT("%d,%d,%d,%f,%d,%d,%d,%f,%f,%f,%f,%f,%f\n"), size.Width, size.Height, grid->GetTileCount(), generationMs, actorSize,
+						respectOccupants ? 1 : 0, result.QueryCount, result.AverageMs, result.P50Ms, result.P99Ms, result.MaxMs, result.AverageExpanded, result.AverageAllocations);
+				}
+			}
+			FDungeonPathBenchmark::LogComparison(FString::Printf(TEXT("%dx%d floor (%d tiles), solvers"), size.Width, size.Height, grid->GetTileCount()),
+				FDungeonPathBenchmark::CompareSolvers(grid->GetTileGraph(), queryCount, seed));
+
+			// Wipe & regenerate the same floor, reusing pooled actors
+			if (regenerationCount > 0)
+			{
+				double totalMs = 0.0;
+				for (int32 i = 0; i < regenerationCount; ++i)
+				{
+					double startTime = FPlatformTime::Seconds();
+					grid->DestroyGeneration();
+					grid->GenerateFloor();
+					totalMs += (FPlatformTime::Seconds() - startTime) * 1000.0;
+				}
+				UE_LOG(LogTemp, Display, TEXT("DungeonPathBenchmark: regenerated %dx%d floor %d times, %.3fms average"), size.Width, size.Height,
+					regenerationCount, totalMs / regenerationCount);
+				grid->LogActorPoolStats();
+			}
+
+			// Every tile with a proxy, as floors were before tiles became graph data, to compare against the counts logged after generating
+			for (int32 i = 0; i < grid->GetTileCount(); ++i)
+				grid->GetTileProxy(i);
+			UE_LOG(LogTemp, Display, TEXT("DungeonPathBenchmark: %dx%d floor with a proxy actor for every tile"), size.Width, size.Height);
+			grid->LogTileMemory();
+		}
+		else
+		{
+			UE_LOG(LogTemp, Error, TEXT("DungeonPathBenchmark: couldn't spawn the game mode for %dx%d"), size.Width, size.Height);
+		}
+
+		GEngine->DestroyWorldContext(world);
+		world->DestroyWorld(false);
+		GWorld = previousWorld;
+		CollectGarbage(RF_NoFlags);
+	}
+
+	// Open ground is where jump point search skips the most, no rooms or world needed
+	if (arenaSize > 0)
+	{
+		FDungeonTileGraph arena;
+		FDungeonPathBenchmark::BuildArena(arena, arenaSize, arenaSize);
+		FDungeonPathBenchmark::LogComparison(FString::Printf(TEXT("%dx%d open arena, solvers"), arenaSize, arenaSize),
+			FDungeonPathBenchmark::CompareSolvers(arena, queryCount, seed));
+	}
+
+	if (!csvPath.IsEmpty() && !FFileHelper::SaveStringToFile(csv, *csvPath))
+	{
+		UE_LOG(LogTemp, Error, TEXT("DungeonPathBenchmark: couldn't write results to '%s'"), *csvPath);
+		return 1;
+	}
+	return 0;
+}
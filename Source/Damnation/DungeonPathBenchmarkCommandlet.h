@@ -0,0 +1,32 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "DungeonPathBenchmarkCommandlet.generated.h"
+
+/**
+ * Headless pathfinding benchmark. Generates a floor for each requested map size in a throwaway world, timing the generation, & runs
+ * FDungeonPathBenchmark on it for 1x1 & 3x3 pathers, with & without respecting occupants. Then compares A* & jump point search on it directly.
+ *
+ * UE4Editor-Cmd Damnation.uproject -run=DungeonPathBenchmark -nullrhi [-Sizes=15x11,20x20,30x30] [-Queries=2000] [-Seed=1]
+ *	[-Grid=/Game/DemoMacroGrid.DemoMacroGrid_C] [-GameMode=/Game/Blueprints/DungeonGamemode.DungeonGamemode_C] [-Csv=path] [-NativeColors=1] [-Regenerations=0] [-Arena=75]
+ *
+ * Sizes are MapMaxWidth x MapMaxHeight; sizes too small for the grids' starter & escape rooms are skipped.
+ * -NativeColors=0 ignores the game modes' native colour actions, so every map colour goes through its Blueprint delegate.
+ * Compare generation times with the same seed to measure the native dispatch; colours need a delegate bound for both runs.
+ * -Regenerations=N then wipes & regenerates each floor N times, logging the average time & the actor pool stats.
+ * The tile memory in use is logged after each floor is generated, against the cost of an actor per tile.
+ * -Arena=N also compares the solvers on an open NxN arena with no rooms, 0 skips it.
+ */
+UCLASS()
+class DAMNATION_API UDungeonPathBenchmarkCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UDungeonPathBenchmarkCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
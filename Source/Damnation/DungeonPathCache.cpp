@@ -0,0 +1,124 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DungeonPathCache.h"
+
+void FDungeonPathCache::SetCapacity(int32 capacity)
+{
+	Capacity = FMath::Max(capacity, 1);
+	Reset();
+}
+
+bool FDungeonPathCache::Find(const FDungeonTileGraph& graph, const FDungeonPathQuery& query, TArray<int32>& outPath, bool& outFound)
+{
+	// Any topology change can affect any path, so drop everything at once
+	if (TopologyVersion != graph.GetTopologyVersion())
+	{
+		Reset();
+		TopologyVersion = graph.GetTopologyVersion();
+	}
+
+	int32* found = Lookup.Find(FKey(query));
+	if (!found)
+	{
+		++Misses;
+		return false;
+	}
+
+	int32 entry = *found;
+	if (Entries[entry].Key.bRespectOccupants && Entries[entry].OccupancyVersion != graph.GetOccupancyVersion())
+	{
+		Remove(entry);
+		++Misses;
+		return false;
+	}
+
+	// Move to the front as the most recently used
+	Unlink(entry);
+	LinkFront(entry);
+	outPath = Entries[entry].Path;
+	outFound = Entries[entry].bFound;
+	++Hits;
+	return true;
+}
+
+void FDungeonPathCache::Add(const FDungeonTileGraph& graph, const FDungeonPathQuery& query, const TArray<int32>& path, bool found)
+{
+	if (TopologyVersion != graph.GetTopologyVersion())
+	{
+		Reset();
+		TopologyVersion = graph.GetTopologyVersion();
+	}
+
+	FKey key(query);
+	if (int32* existing = Lookup.Find(key))
+		Remove(*existing);
+
+	int32 entry;
+	if (FreeEntries.Num() > 0)
+	{
+		entry = FreeEntries.Pop(false);
+	}
+	else if (Entries.Num() < Capacity)
+	{
+		entry = Entries.Add({ key, TArray<int32>(), false, 0, INDEX_NONE, INDEX_NONE });
+	}
+	else
+	{
+		// Full, evict the least recently used
+		entry = Tail;
+		Lookup.Remove(Entries[entry].Key);
+		Unlink(entry);
+	}
+
+	FEntry& slot = Entries[entry];
+	slot.Key = key;
+	slot.Path = path;
+	slot.bFound = found;
+	slot.OccupancyVersion = graph.GetOccupancyVersion();
+	Lookup.Add(key, entry);
+	LinkFront(entry);
+}
+
+void FDungeonPathCache::Reset()
+{
+	Entries.Reset();
+	Lookup.Reset();
+	FreeEntries.Reset();
+	Head = INDEX_NONE;
+	Tail = INDEX_NONE;
+}
+
+void FDungeonPathCache::Unlink(int32 entry)
+{
+	FEntry& slot = Entries[entry];
+	if (slot.Prev != INDEX_NONE)
+		Entries[slot.Prev].Next = slot.Next;
+	else
+		Head = slot.Next;
+	if (slot.Next != INDEX_NONE)
+		Entries[slot.Next].Prev = slot.Prev;
+	else
+		Tail = slot.Prev;
+	slot.Prev = INDEX_NONE;
+	slot.Next = INDEX_NONE;
+}
+
+void FDungeonPathCache::LinkFront(int32 entry)
+{
+	FEntry& slot = Entries[entry];
+	slot.Prev = INDEX_NONE;
+	slot.Next = Head;
+	if (Head != INDEX_NONE)
+		Entries[Head].Prev = entry;
+	Head = entry;
+	if (Tail == INDEX_NONE)
+		Tail = entry;
+}
+
+void FDungeonPathCache::Remove(int32 entry)
+{
+	Lookup.Remove(Entries[entry].Key);
+	Unlink(entry);
+	Entries[entry].Path.Reset();
+	FreeEntries.Add(entry);
+}
@@ -0,0 +1,101 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DungeonPathfinding.h"
+
+/*
+* Least recently used cache of pathfinding results.
+* Every entry is dropped once the graphs' topology version changes (connections, pathing permission or space),
+* & entries for queries that respect occupants are also dropped once the occupancy version changes.
+* Failed searches are cached too, so repeatedly asking for an unreachable tile is just as cheap.
+* Not thread-safe, only used by game thread queries.
+*/
+class DAMNATION_API FDungeonPathCache
+{
+public:
+	explicit FDungeonPathCache(int32 capacity = 64) : Capacity(FMath::Max(capacity, 1)) {}
+
+	// Changes the number of paths kept, discarding every cached path.
+	void SetCapacity(int32 capacity);
+	int32 GetCapacity() const { return Capacity; }
+
+	// Copies the cached result for query into outPath if one is still valid for graph. Returns false on a miss.
+	// outFound is set to whether the cached search found a path.
+	bool Find(const FDungeonTileGraph& graph, const FDungeonPathQuery& query, TArray<int32>& outPath, bool& outFound);
+
+	// Stores the result of a search, evicting the least recently used path if full.
+	void Add(const FDungeonTileGraph& graph, const FDungeonPathQuery& query, const TArray<int32>& path, bool found);
+
+	// Discards every cached path, keeping the hit & miss counts.
+	void Reset();
+
+	int32 Num() const { return Lookup.Num(); }
+
+	// Hit & miss counts for tuning the capacity
+	int32 GetHits() const { return Hits; }
+	int32 GetMisses() const { return Misses; }
+	void ResetStats() { Hits = Misses = 0; }
+
+private:
+	struct FKey
+	{
+		int32 Start = INDEX_NONE;
+		int32 End = INDEX_NONE;
+		int ActorSize = 1;
+		uint32 IgnoredOccupant = 0;
+		bool bGetClosest = true;
+		bool bRespectOccupants = false;
+
+		FKey() {}
+		explicit FKey(const FDungeonPathQuery& query)
+			: Start(query.Start), End(query.End), ActorSize(query.ActorSize), IgnoredOccupant(query.IgnoredOccupant),
+			bGetClosest(query.bGetClosest), bRespectOccupants(query.bRespectOccupants) {}
+
+		bool operator==(const FKey& other) const
+		{
+			return Start == other.Start && End == other.End && ActorSize == other.ActorSize && IgnoredOccupant == other.IgnoredOccupant
+				&& bGetClosest == other.bGetClosest && bRespectOccupants == other.bRespectOccupants;
+		}
+
+		friend uint32 GetTypeHash(const FKey& key)
+		{
+			uint32 hash = HashCombine(GetTypeHash(key.Start), GetTypeHash(key.End));
+			hash = HashCombine(hash, GetTypeHash(key.IgnoredOccupant));
+			return HashCombine(hash, (uint32)key.ActorSize << 2 | (uint32)key.bGetClosest << 1 | (uint32)key.bRespectOccupants);
+		}
+	};
+
+	struct FEntry
+	{
+		FKey Key;
+		TArray<int32> Path;
+		bool bFound;
+		// Occupancy version the path was found against, only checked for queries that respect occupants.
+		uint32 OccupancyVersion;
+		// Neighbours in recency order, INDEX_NONE at either end.
+		int32 Prev;
+		int32 Next;
+	};
+
+	// Recency list functionality
+	void Unlink(int32 entry);
+	void LinkFront(int32 entry);
+	void Remove(int32 entry);
+
+	int32 Capacity;
+	TArray<FEntry> Entries;
+	TMap<FKey, int32> Lookup;
+	// Entries freed by stale removals, reused before growing
+	TArray<int32> FreeEntries;
+	// Most & least recently used entries
+	int32 Head = INDEX_NONE;
+	int32 Tail = INDEX_NONE;
+
+	// Topology version every cached path was found against
+	uint32 TopologyVersion = 0;
+
+	int32 Hits = 0;
+	int32 Misses = 0;
+};
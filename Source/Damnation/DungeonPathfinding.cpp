@@ -0,0 +1,94 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DungeonPathfinding.h"
+#include "Algo/Reverse.h"
+
+bool FDungeonPathfinder::FindPath(const FDungeonTileGraph& graph, FDungeonPathContext& context, const FDungeonPathQuery& query, TArray<int32>& outPath)
+{
+	outPath.Reset();
+
+	const int32 start = query.Start;
+	const int32 end = query.End;
+	// Return empty if start == end, standing on desired tile
+	if (start == end || !graph.IsValidTile(start) || !graph.IsValidTile(end))
+		return false;
+
+	context.Begin(graph.Num());
+
+	const FVector& endLocation = graph.GetLocation(end);
+
+	FDungeonPathNode& startNode = context.GetNode(start);
+	startNode.hCost = FVector::DistSquared(graph.GetLocation(start), endLocation);
+	context.Push(start);
+	// Store closest tile to target every iteration incase pathfinding fails
+	int32 closest = start;
+	float closestDistance = startNode.hCost;
+
+	while (context.OpenNum() > 0)
+	{
+		int32 current = context.Pop();
+		FDungeonPathNode& currentNode = context.GetNode(current);
+		float currentDistance = FVector::DistSquared(graph.GetLocation(current), endLocation);
+		if (currentDistance < closestDistance)
+		{
+			closest = current;
+			closestDistance = currentDistance;
+		}
+		currentNode.bClosed = true;
+		if (current == end)
+		{
+			outPath.Add(current);
+			while (context.GetNode(current).Parent != start)
+			{
+				current = context.GetNode(current).Parent;
+				outPath.Add(current);
+			}
+			Algo::Reverse(outPath);
+			return true;
+		}
+		for (int32 dir = 0; dir < FDungeonTileGraph::CardinalCount; ++dir)
+		{
+			int32 connection = graph.GetNeighbour(current, dir);
+			// IF
+			// Connection exists, the closed list has the connection already, there's not enough space for the pather, or if the tile is set to be ignored
+			if (connection == INDEX_NONE ||
+				context.IsClosed(connection) ||
+				graph.GetAvailableSpace(connection) < query.ActorSize ||
+				graph.IsPathingIgnored(connection))
+				continue;
+			float sqrDistance = currentDistance;
+			// If the tile is occupied, increase the cost to encourage routing around obstacles.
+			if (query.bRespectOccupants)
+			{
+				uint32 occupant = graph.GetOccupant(connection);
+				if (occupant != 0 && occupant != query.IgnoredOccupant)
+					sqrDistance *= 1.1;
+			}
+
+			float moveCost = currentNode.gCost + sqrDistance;
+			bool bInOpenList = context.IsOpen(connection);
+			FDungeonPathNode& connectionNode = context.GetNode(connection);
+			if (moveCost < connectionNode.gCost || !bInOpenList)
+			{
+				connectionNode.gCost = moveCost;
+				connectionNode.hCost = sqrDistance;
+				connectionNode.Parent = current;
+				// Reorder only the changed node rather than resorting the whole list
+				if (bInOpenList)
+					context.Update(connection);
+				else
+					context.Push(connection);
+			}
+		}
+	}
+	// Cannot reach the desired position, pathfind to the closest valid position instead if desired.
+	if (query.bGetClosest && closest != start)
+	{
+		FDungeonPathQuery closestQuery = query;
+		closestQuery.End = closest;
+		closestQuery.bGetClosest = false;
+		closestQuery.bRespectOccupants = false;
+		return FindPath(graph, context, closestQuery, outPath);
+	}
+	return false;
+}
@@ -0,0 +1,252 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "DungeonTileGraph.h"
+
+// Per-query A* state for a single tile, keyed by the tiles' compact index.
+struct FDungeonPathNode
+{
+	float gCost = 0.0f;
+	float hCost = 0.0f;
+	int32 Parent = INDEX_NONE;
+	// Position in the open list, INDEX_NONE when not in it.
+	int32 HeapIndex = INDEX_NONE;
+	bool bClosed = false;
+	// The search this record belongs to. Records from older searches are treated as untouched.
+	uint32 Generation = 0;
+
+	float fCost() const { return gCost + hCost; }
+};
+
+/*
+* Reusable scratch space for a single pathfinding query.
+* Node records are stamped with the search generation, so starting a new search is O(1) rather than clearing every record.
+* A context must only be used by one search at a time; acquire one per query from FDungeonPathContextPool.
+*/
+class DAMNATION_API FDungeonPathContext
+{
+public:
+	// Prepares the context for a new search over a graph of nodeCount tiles.
+	void Begin(int32 nodeCount)
+	{
+		if (Nodes.Num() < nodeCount)
+			Nodes.SetNum(nodeCount);
+		OpenList.Reset();
+		// Generation wrapped around, stale stamps could now collide so clear them once.
+		if (++Generation == 0)
+		{
+			for (FDungeonPathNode& node : Nodes)
+				node.Generation = 0;
+			Generation = 1;
+		}
+	}
+
+	// Gets the record for a node, resetting it first if it was last touched by an older search.
+	FDungeonPathNode& GetNode(int32 index)
+	{
+		FDungeonPathNode& node = Nodes[index];
+		if (node.Generation != Generation)
+		{
+			node = FDungeonPathNode();
+			node.Generation = Generation;
+		}
+		return node;
+	}
+
+	// Gets the record for a node without modifying it, nullptr if the current search hasn't touched it.
+	const FDungeonPathNode* FindNode(int32 index) const
+	{
+		return Nodes.IsValidIndex(index) && Nodes[index].Generation == Generation ? &Nodes[index] : nullptr;
+	}
+
+	bool IsOpen(int32 index) const { return Nodes[index].Generation == Generation && Nodes[index].HeapIndex != INDEX_NONE; }
+	bool IsClosed(int32 index) const { return Nodes[index].Generation == Generation && Nodes[index].bClosed; }
+
+	// Open list functionality
+	// Indexed binary min-heap, the node's HeapIndex allows its priority to be changed in place (decrease-key).
+	// Push, Update & Pop are O(log n) & IsOpen is O(1), so a search over n tiles is O(n log n).
+
+	int32 OpenNum() const { return OpenList.Num(); }
+
+	void Push(int32 index)
+	{
+		GetNode(index).HeapIndex = OpenList.Add(index);
+		SiftUp(Nodes[index].HeapIndex);
+	}
+
+	// Call after changing a node's cost to restore heap order.
+	// The heuristic used by GeneratePath depends on the parent, so the f cost may move either way.
+	void Update(int32 index)
+	{
+		SiftUp(Nodes[index].HeapIndex);
+		SiftDown(Nodes[index].HeapIndex);
+	}
+
+	// The node with the lowest f cost, without removing it.
+	int32 Peek() const { return OpenList[0]; }
+
+	// Removes a node from anywhere in the open list, without counting it as expanded.
+	void Remove(int32 index)
+	{
+		int32 heapIndex = Nodes[index].HeapIndex;
+		int32 last = OpenList.Pop(false);
+		Nodes[index].HeapIndex = INDEX_NONE;
+		if (last != index)
+		{
+			Place(last, heapIndex);
+			Update(last);
+		}
+	}
+
+	// Removes & returns the node with the lowest f cost.
+	int32 Pop()
+	{
+		++ExpandedCount;
+		int32 top = OpenList[0];
+		int32 last = OpenList.Pop(false);
+		if (OpenList.Num() > 0)
+		{
+			Place(last, 0);
+			SiftDown(0);
+		}
+		Nodes[top].HeapIndex = INDEX_NONE;
+		return top;
+	}
+
+	// Nodes popped from the open list over every search run with this context, for benchmarking.
+	uint64 GetExpandedCount() const { return ExpandedCount; }
+
+private:
+	// Lower f cost first, ties broken towards the node closer to the target.
+	bool Less(int32 a, int32 b) const
+	{
+		float fA = Nodes[a].fCost();
+		float fB = Nodes[b].fCost();
+		return fA < fB || (fA == fB && Nodes[a].hCost < Nodes[b].hCost);
+	}
+
+	void Place(int32 node, int32 heapIndex)
+	{
+		OpenList[heapIndex] = node;
+		Nodes[node].HeapIndex = heapIndex;
+	}
+
+	void SiftUp(int32 heapIndex)
+	{
+		int32 node = OpenList[heapIndex];
+		while (heapIndex > 0)
+		{
+			int32 parentIndex = (heapIndex - 1) / 2;
+			if (!Less(node, OpenList[parentIndex]))
+				break;
+			Place(OpenList[parentIndex], heapIndex);
+			heapIndex = parentIndex;
+		}
+		Place(node, heapIndex);
+	}
+
+	void SiftDown(int32 heapIndex)
+	{
+		int32 node = OpenList[heapIndex];
+		const int32 count = OpenList.Num();
+		while (true)
+		{
+			int32 child = heapIndex * 2 + 1;
+			if (child >= count)
+				break;
+			if (child + 1 < count && Less(OpenList[child + 1], OpenList[child]))
+				++child;
+			if (!Less(OpenList[child], node))
+				break;
+			Place(OpenList[child], heapIndex);
+			heapIndex = child;
+		}
+		Place(node, heapIndex);
+	}
+
+	TArray<FDungeonPathNode> Nodes;
+	TArray<int32> OpenList;
+	uint32 Generation = 0;
+	uint64 ExpandedCount = 0;
+};
+
+/*
+* Thread-safe pool of search contexts.
+* Each concurrent GeneratePath call takes its own context, so searches on different threads never share scratch space.
+* Contexts are kept once created, so steady-state queries don't allocate.
+*/
+class DAMNATION_API FDungeonPathContextPool
+{
+public:
+	FDungeonPathContext* Acquire()
+	{
+		FScopeLock lock(&PoolLock);
+		if (FreeContexts.Num() > 0)
+			return FreeContexts.Pop(false);
+		AllContexts.Add(MakeUnique<FDungeonPathContext>());
+		return AllContexts.Last().Get();
+	}
+
+	void Release(FDungeonPathContext* context)
+	{
+		FScopeLock lock(&PoolLock);
+		FreeContexts.Add(context);
+	}
+
+	// Nodes expanded by every context in the pool, for benchmarking.
+	uint64 GetExpandedCount()
+	{
+		FScopeLock lock(&PoolLock);
+		uint64 count = 0;
+		for (const TUniquePtr<FDungeonPathContext>& context : AllContexts)
+			count += context->GetExpandedCount();
+		return count;
+	}
+
+private:
+	FCriticalSection PoolLock;
+	TArray<TUniquePtr<FDungeonPathContext>> AllContexts;
+	TArray<FDungeonPathContext*> FreeContexts;
+};
+
+// Holds a context from the pool for the lifetime of the scope.
+class FDungeonScopedPathContext
+{
+public:
+	explicit FDungeonScopedPathContext(FDungeonPathContextPool& pool) : Pool(pool), Context(pool.Acquire()) {}
+	~FDungeonScopedPathContext() { Pool.Release(Context); }
+
+	FDungeonPathContext& Get() { return *Context; }
+
+private:
+	FDungeonPathContextPool& Pool;
+	FDungeonPathContext* Context;
+};
+
+// Parameters for a single pathfinding query over the tile graph.
+struct FDungeonPathQuery
+{
+	int32 Start = INDEX_NONE;
+	int32 End = INDEX_NONE;
+	int ActorSize = 1;
+	// If the end can't be reached, path to the closest reachable tile instead.
+	bool bGetClosest = true;
+	// Increase the cost of occupied tiles to encourage routing around other occupants.
+	bool bRespectOccupants = false;
+	// Occupant handle that is never treated as an obstacle, typically the player.
+	uint32 IgnoredOccupant = 0;
+};
+
+/*
+* A* over FDungeonTileGraph.
+* Only reads the graph, so any number of searches can run at once provided each has its own context.
+*/
+struct DAMNATION_API FDungeonPathfinder
+{
+	// Fills outPath with the tile indices from the tile after Start up to & including the target.
+	// Returns false if no path was found, outPath is left empty.
+	static bool FindPath(const FDungeonTileGraph& graph, FDungeonPathContext& context, const FDungeonPathQuery& query, TArray<int32>& outPath);
+};
@@ -0,0 +1,65 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DungeonRespawnScheduler.h"
+#include "DungeonRoomTileBase.h"
+
+void FDungeonRespawnScheduler::Schedule(ADungeonRoomTileBase* room, float time)
+{
+	if (!room)
+		return;
+	FEntry entry;
+	entry.Time = time;
+	entry.Ticket = ++NextTicket;
+	entry.Room = room;
+	Tickets.Add(room, entry.Ticket);
+	Heap.HeapPush(entry);
+}
+
+void FDungeonRespawnScheduler::Cancel(const ADungeonRoomTileBase* room)
+{
+	Tickets.Remove(room);
+}
+
+bool FDungeonRespawnScheduler::IsCurrent(const FEntry& entry) const
+{
+	ADungeonRoomTileBase* room = entry.Room.Get();
+	const uint32* ticket = room ? Tickets.Find(room) : nullptr;
+	return ticket && *ticket == entry.Ticket;
+}
+
+void FDungeonRespawnScheduler::PopStale()
+{
+	FEntry entry;
+	while (Heap.Num() > 0 && !IsCurrent(Heap.HeapTop()))
+		Heap.HeapPop(entry, false);
+}
+
+void FDungeonRespawnScheduler::PopDue(float now, TArray<ADungeonRoomTileBase*>& outRooms)
+{
+	FEntry entry;
+	for (PopStale(); Heap.Num() > 0 && Heap.HeapTop().Time <= now; PopStale())
+	{
+		Heap.HeapPop(entry, false);
+		Tickets.Remove(entry.Room.Get());
+		outRooms.Add(entry.Room.Get());
+	}
+}
+
+bool FDungeonRespawnScheduler::GetNextTime(float& outTime)
+{
+	PopStale();
+	if (Heap.Num() == 0)
+	{
+		// Destroyed rooms never get cancelled, so their tickets go here
+		Tickets.Reset();
+		return false;
+	}
+	outTime = Heap.HeapTop().Time;
+	return true;
+}
+
+void FDungeonRespawnScheduler::Reset()
+{
+	Heap.Reset();
+	Tickets.Reset();
+}
@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+class ADungeonRoomTileBase;
+
+/*
+* Queue of when each room next checks for enemies to respawn, earliest first.
+* Rooms are only touched when their check is due, so the cost no longer depends on how many rooms are on the floor.
+* A room has at most one check queued; scheduling it again or cancelling it leaves the old entry behind to be skipped when popped.
+* Rooms due at the same time are popped in the order they were scheduled. Only used on the game thread.
+*/
+class DAMNATION_API FDungeonRespawnScheduler
+{
+public:
+	// Queues room to be woken at time, replacing any check already queued for it.
+	void Schedule(ADungeonRoomTileBase* room, float time);
+
+	// Removes any check queued for room.
+	void Cancel(const ADungeonRoomTileBase* room);
+
+	// Removes every room due by now & adds them to outRooms, earliest first.
+	void PopDue(float now, TArray<ADungeonRoomTileBase*>& outRooms);
+
+	// Gets the time the earliest queued room is due. Returns false if no room is queued.
+	bool GetNextTime(float& outTime);
+
+	// Removes every queued check.
+	void Reset();
+
+	// Number of rooms with a check queued, counting destroyed rooms until their check is reached.
+	int32 Num() const { return Tickets.Num(); }
+
+private:
+	struct FEntry
+	{
+		float Time;
+		// Increases with every Schedule call, so also orders rooms due at the same time
+		uint32 Ticket;
+		TWeakObjectPtr<ADungeonRoomTileBase> Room;
+
+		bool operator<(const FEntry& other) const { return Time != other.Time ? Time < other.Time : Ticket < other.Ticket; }
+	};
+
+	// Whether entry is still the rooms' queued check.
+	bool IsCurrent(const FEntry& entry) const;
+	// Pops entries that have been replaced or cancelled, or whose room has been destroyed, off the top of the heap.
+	void PopStale();
+
+	// Min-heap on time
+	TArray<FEntry> Heap;
+	// Ticket of each rooms' queued check
+	TMap<const ADungeonRoomTileBase*, uint32> Tickets;
+	uint32 NextTicket = 0;
+};
@@ -0,0 +1,41 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DungeonRoomClassIndex.h"
+#include "DungeonRoomTileBase.h"
+
+void FDungeonRoomClassIndex::Build(const TArray<TSubclassOf<ADungeonRoomTileBase>>& rooms)
+{
+	for (FBucket& bucket : Buckets)
+	{
+		bucket.LeastUsed.Reset();
+		bucket.Used.Reset();
+	}
+	for (const TSubclassOf<ADungeonRoomTileBase>& room : rooms)
+		if (room)
+			Buckets[MakeMask(room.GetDefaultObject()->ValidCardinals)].LeastUsed.Add(room);
+}
+
+uint8 FDungeonRoomClassIndex::MakeMask(const TArray<bool>& connectors)
+{
+	uint8 mask = 0;
+	for (int32 i = 0; i < 4 && i < connectors.Num(); ++i)
+		if (connectors[i])
+			mask |= 1 << i;
+	return mask;
+}
+
+TSubclassOf<ADungeonRoomTileBase> FDungeonRoomClassIndex::PickLeastUsed(uint8 mask, FRandomStream& stream)
+{
+	FBucket& bucket = Buckets[mask];
+	// Every class has now been used equally, start the next round
+	if (bucket.LeastUsed.Num() == 0)
+		Swap(bucket.LeastUsed, bucket.Used);
+	if (bucket.LeastUsed.Num() == 0)
+		return nullptr;
+
+	int32 pick = stream.RandRange(0, bucket.LeastUsed.Num() - 1);
+	TSubclassOf<ADungeonRoomTileBase> room = bucket.LeastUsed[pick];
+	bucket.LeastUsed.RemoveAtSwap(pick, 1, false);
+	bucket.Used.Add(room);
+	return room;
+}
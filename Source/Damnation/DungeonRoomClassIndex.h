@@ -0,0 +1,41 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Math/RandomStream.h"
+
+class ADungeonRoomTileBase;
+
+/*
+* Room classes grouped by connector mask (bit n set if ValidCardinals[n]) for floor generation.
+* A class only ever matches its own mask, so within a bucket every class has been used either the bucket's minimum
+* number of times or one more. Each bucket keeps those two groups apart, making picking the least used class O(1).
+*/
+class DAMNATION_API FDungeonRoomClassIndex
+{
+public:
+	static const int32 MaskCount = 16;
+
+	// Rebuilds the index from a room list, reading each class' connectors once. Every use count is reset.
+	void Build(const TArray<TSubclassOf<ADungeonRoomTileBase>>& rooms);
+
+	// Packs the first four connector flags into a mask.
+	static uint8 MakeMask(const TArray<bool>& connectors);
+
+	bool HasRoom(uint8 mask) const { return Buckets[mask].LeastUsed.Num() + Buckets[mask].Used.Num() > 0; }
+
+	// Picks one of the least used classes matching mask at random from stream & counts the use. Returns nullptr if none match.
+	TSubclassOf<ADungeonRoomTileBase> PickLeastUsed(uint8 mask, FRandomStream& stream);
+
+private:
+	struct FBucket
+	{
+		// Classes used the minimum number of times
+		TArray<TSubclassOf<ADungeonRoomTileBase>> LeastUsed;
+		// Classes used once more than that
+		TArray<TSubclassOf<ADungeonRoomTileBase>> Used;
+	};
+
+	FBucket Buckets[MaskCount];
+};
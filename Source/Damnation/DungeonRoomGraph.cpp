@@ -0,0 +1,368 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DungeonRoomGraph.h"
+#include "DungeonPathfinding.h"
+#include "DungeonRoomTileBase.h"
+#include "Algo/Reverse.h"
+
+const int FDungeonRoomGraph::LayerSizes[FDungeonRoomGraph::LayerCount] = { 1, 3 };
+
+namespace
+{
+	const int32 RoomTileCount = ADungeonRoomTileBase::RoomTileCount;
+	const uint16 Unreachable = MAX_uint16;
+
+	bool CanEnter(const FDungeonTileGraph& graph, int32 tile, int actorSize)
+	{
+		return graph.GetAvailableSpace(tile) >= actorSize && !graph.IsPathingIgnored(tile);
+	}
+
+	bool IsAdjacent(const FDungeonTileGraph& graph, int32 a, int32 b)
+	{
+		for (int32 dir = 0; dir < FDungeonTileGraph::CardinalCount; ++dir)
+			if (graph.GetNeighbour(a, dir) == b)
+				return true;
+		return false;
+	}
+
+	// Breadth first search from a tile over the rest of its room.
+	// distances & parents are indexed by the tiles' local index, parents holds tile indices & may be null.
+	void SearchRoom(const FDungeonTileGraph& graph, int32 from, int actorSize, uint16* distances, int32* parents)
+	{
+		const int32 room = graph.GetRoom(from);
+		for (int32 i = 0; i < RoomTileCount; ++i)
+			distances[i] = Unreachable;
+
+		// Every tile is queued at most once, so the queue never wraps
+		int32 queue[RoomTileCount];
+		int32 head = 0;
+		int32 tail = 0;
+		distances[graph.GetLocalIndex(from)] = 0;
+		if (parents)
+			parents[graph.GetLocalIndex(from)] = INDEX_NONE;
+		queue[tail++] = from;
+
+		while (head < tail)
+		{
+			int32 current = queue[head++];
+			uint16 nextDistance = distances[graph.GetLocalIndex(current)] + 1;
+			for (int32 dir = 0; dir < FDungeonTileGraph::CardinalCount; ++dir)
+			{
+				int32 connection = graph.GetNeighbour(current, dir);
+				if (connection == INDEX_NONE || graph.GetRoom(connection) != room || !CanEnter(graph, connection, actorSize))
+					continue;
+				int32 local = graph.GetLocalIndex(connection);
+				if (distances[local] != Unreachable)
+					continue;
+				distances[local] = nextDistance;
+				if (parents)
+					parents[local] = current;
+				queue[tail++] = connection;
+			}
+		}
+	}
+}
+
+bool FDungeonRoomRoute::RefineNext(const FDungeonTileGraph& graph, TArray<int32>& outPath)
+{
+	if (!HasSegments())
+		return false;
+	int32 from = Waypoints[NextWaypoint - 1];
+	int32 to = Waypoints[NextWaypoint];
+	++NextWaypoint;
+
+	TArray<int32> segment;
+	if (!FDungeonRoomGraph::FindRoomPath(graph, from, to, ActorSize, segment))
+		return false;
+	outPath.Append(segment);
+	return true;
+}
+
+bool FDungeonRoomRoute::RefineAll(const FDungeonTileGraph& graph, TArray<int32>& outPath)
+{
+	while (HasSegments())
+		if (!RefineNext(graph, outPath))
+			return false;
+	return true;
+}
+
+int32 FDungeonRoomGraph::GetLayer(int actorSize)
+{
+	for (int32 layer = 0; layer < LayerCount; ++layer)
+		if (actorSize <= LayerSizes[layer])
+			return layer;
+	return INDEX_NONE;
+}
+
+int32 FDungeonRoomGraph::GetPortalCount(int actorSize) const
+{
+	int32 layer = GetLayer(actorSize);
+	return layer == INDEX_NONE ? 0 : Layers[layer].PortalTiles.Num();
+}
+
+void FDungeonRoomGraph::Reset()
+{
+	RoomBorders.Reset();
+	for (FLayer& layer : Layers)
+	{
+		layer.Rooms.Reset();
+		layer.PortalTiles.Reset();
+		layer.PortalRooms.Reset();
+		layer.PortalPartners.Reset();
+	}
+	bBuilt = false;
+}
+
+void FDungeonRoomGraph::Update(const FDungeonTileGraph& graph)
+{
+	if (IsUpToDate(graph))
+		return;
+
+	// Gather every two-way link between tiles of different rooms, grouped by the pair of rooms
+	const int32 roomCount = graph.GetRoomCount();
+	RoomBorders.SetNum(roomCount);
+	TMap<uint64, TArray<FBorderPair>> borders;
+	for (int32 roomA = 0; roomA < roomCount; ++roomA)
+	{
+		FRoomBorders& roomBorders = RoomBorders[roomA];
+		const uint32 version = graph.GetRoomTopologyVersion(roomA);
+		// Only rescan rooms that have changed since they were last scanned
+		if (!roomBorders.bValid || roomBorders.Version != version)
+		{
+			roomBorders.Pairs.Reset();
+			for (int32 tile : graph.GetRoomTiles(roomA))
+			{
+				for (int32 dir = 0; dir < FDungeonTileGraph::CardinalCount; ++dir)
+				{
+					int32 other = graph.GetNeighbour(tile, dir);
+					if (other != INDEX_NONE && graph.GetRoom(other) > roomA)
+						roomBorders.Pairs.Add({ tile, other });
+				}
+			}
+			roomBorders.Version = version;
+			roomBorders.bValid = true;
+		}
+		// The link back belongs to the other room, which may have changed without this one
+		for (const FBorderPair& pair : roomBorders.Pairs)
+			if (IsAdjacent(graph, pair.B, pair.A))
+				borders.FindOrAdd(((uint64)roomA << 32) | (uint32)graph.GetRoom(pair.B)).Add(pair);
+	}
+	// Border tiles increase in local index along the border, so sorting puts the pairs in walking order
+	for (auto& border : borders)
+		border.Value.Sort([&graph](const FBorderPair& lhs, const FBorderPair& rhs) { return graph.GetLocalIndex(lhs.A) < graph.GetLocalIndex(rhs.A); });
+
+	for (int32 l = 0; l < LayerCount; ++l)
+	{
+		const int actorSize = LayerSizes[l];
+		FLayer& layer = Layers[l];
+
+		TArray<TArray<int32>> roomTiles;
+		roomTiles.SetNum(roomCount);
+		// Portal pairs as (room, slot) for each side, resolved into flat indices once every room is laid out
+		TArray<TPair<TPair<int32, int32>, TPair<int32, int32>>> links;
+
+		for (const auto& border : borders)
+		{
+			const int32 roomA = (int32)(border.Key >> 32);
+			const int32 roomB = (int32)(border.Key & 0xFFFFFFFF);
+			const TArray<FBorderPair>& pairs = border.Value;
+
+			// Split the border into runs of contiguous pairs both sides can stand on, each run gets portals at its ends & middle
+			int32 runStart = INDEX_NONE;
+			for (int32 i = 0; i <= pairs.Num(); ++i)
+			{
+				bool valid = i < pairs.Num() && CanEnter(graph, pairs[i].A, actorSize) && CanEnter(graph, pairs[i].B, actorSize);
+				bool contiguous = valid && runStart != INDEX_NONE &&
+					IsAdjacent(graph, pairs[i - 1].A, pairs[i].A) && IsAdjacent(graph, pairs[i - 1].B, pairs[i].B);
+				if (runStart != INDEX_NONE && !contiguous)
+				{
+					constexpr int32 RunPortalCount = 3;
+					const int32 runPairs[RunPortalCount] = { runStart, (runStart + i - 1) / 2, i - 1 };
+					for (int32 p = 0; p < RunPortalCount; ++p)
+					{
+						// Short runs share their ends & middle
+						if (p > 0 && runPairs[p] == runPairs[p - 1])
+							continue;
+						const FBorderPair& portal = pairs[runPairs[p]];
+						int32 slotA = roomTiles[roomA].Add(portal.A);
+						int32 slotB = roomTiles[roomB].Add(portal.B);
+						links.Add({ { roomA, slotA }, { roomB, slotB } });
+					}
+					runStart = INDEX_NONE;
+				}
+				if (valid && runStart == INDEX_NONE)
+					runStart = i;
+			}
+		}
+
+		layer.Rooms.SetNum(roomCount);
+		layer.PortalTiles.Reset();
+		layer.PortalRooms.Reset();
+		for (int32 room = 0; room < roomCount; ++room)
+		{
+			FRoomPortals& portals = layer.Rooms[room];
+			const uint32 version = graph.GetRoomTopologyVersion(room);
+			// Only search rooms that have changed since they were last built
+			if (!portals.bValid || portals.Version != version || portals.Tiles != roomTiles[room])
+			{
+				portals.Tiles = MoveTemp(roomTiles[room]);
+				const int32 count = portals.Tiles.Num();
+				portals.Distances.SetNumUninitialized(count * count);
+				uint16 distances[RoomTileCount];
+				for (int32 i = 0; i < count; ++i)
+				{
+					SearchRoom(graph, portals.Tiles[i], actorSize, distances, nullptr);
+					for (int32 j = 0; j < count; ++j)
+						portals.Distances[i * count + j] = distances[graph.GetLocalIndex(portals.Tiles[j])];
+				}
+				portals.Version = version;
+				portals.bValid = true;
+			}
+
+			portals.FirstPortal = layer.PortalTiles.Num();
+			layer.PortalTiles.Append(portals.Tiles);
+			for (int32 i = 0; i < portals.Tiles.Num(); ++i)
+				layer.PortalRooms.Add(room);
+		}
+
+		layer.PortalPartners.Init(INDEX_NONE, layer.PortalTiles.Num());
+		for (const auto& link : links)
+		{
+			int32 a = layer.Rooms[link.Key.Key].FirstPortal + link.Key.Value;
+			int32 b = layer.Rooms[link.Value.Key].FirstPortal + link.Value.Value;
+			layer.PortalPartners[a] = b;
+			layer.PortalPartners[b] = a;
+		}
+	}
+
+	BuiltVersion = graph.GetTopologyVersion();
+	bBuilt = true;
+}
+
+bool FDungeonRoomGraph::FindRoute(const FDungeonTileGraph& graph, FDungeonPathContext& context, int32 start, int32 end, int actorSize, FDungeonRoomRoute& outRoute) const
+{
+	outRoute.Reset();
+	const int32 l = GetLayer(actorSize);
+	if (l == INDEX_NONE || !IsUpToDate(graph) || !graph.IsValidTile(start) || !graph.IsValidTile(end))
+		return false;
+
+	const FLayer& layer = Layers[l];
+	const int32 startRoom = graph.GetRoom(start);
+	const int32 endRoom = graph.GetRoom(end);
+	if (startRoom == endRoom || !layer.Rooms.IsValidIndex(startRoom) || !layer.Rooms.IsValidIndex(endRoom) || !CanEnter(graph, end, actorSize))
+		return false;
+
+	// Connect the start & end to the portals of their rooms
+	uint16 startDistances[RoomTileCount];
+	uint16 endDistances[RoomTileCount];
+	SearchRoom(graph, start, actorSize, startDistances, nullptr);
+	SearchRoom(graph, end, actorSize, endDistances, nullptr);
+
+	// Portals are nodes 0..PortalCount-1, the end is the one after
+	const int32 goal = layer.PortalTiles.Num();
+	context.Begin(goal + 1);
+
+	auto heuristic = [&](int32 tile) { return graph.EstimateSteps(tile, end); };
+	auto relax = [&](int32 node, float gCost, float hCost, int32 parent)
+	{
+		if (context.IsClosed(node))
+			return;
+		bool bInOpenList = context.IsOpen(node);
+		FDungeonPathNode& record = context.GetNode(node);
+		if (bInOpenList && gCost >= record.gCost)
+			return;
+		record.gCost = gCost;
+		record.hCost = hCost;
+		record.Parent = parent;
+		if (bInOpenList)
+			context.Update(node);
+		else
+			context.Push(node);
+	};
+
+	const FRoomPortals& startPortals = layer.Rooms[startRoom];
+	for (int32 i = 0; i < startPortals.Tiles.Num(); ++i)
+	{
+		uint16 distance = startDistances[graph.GetLocalIndex(startPortals.Tiles[i])];
+		if (distance != Unreachable)
+			relax(startPortals.FirstPortal + i, distance, heuristic(startPortals.Tiles[i]), INDEX_NONE);
+	}
+
+	while (context.OpenNum() > 0)
+	{
+		int32 current = context.Pop();
+		FDungeonPathNode& currentNode = context.GetNode(current);
+		currentNode.bClosed = true;
+		const float gCost = currentNode.gCost;
+
+		if (current == goal)
+		{
+			outRoute.Waypoints.Add(end);
+			for (int32 node = currentNode.Parent; node != INDEX_NONE; node = context.GetNode(node).Parent)
+			{
+				// Corner tiles can be portals to two rooms, don't visit them twice
+				if (layer.PortalTiles[node] != outRoute.Waypoints.Last())
+					outRoute.Waypoints.Add(layer.PortalTiles[node]);
+			}
+			if (outRoute.Waypoints.Last() != start)
+				outRoute.Waypoints.Add(start);
+			Algo::Reverse(outRoute.Waypoints);
+			outRoute.ActorSize = actorSize;
+			return true;
+		}
+
+		const int32 room = layer.PortalRooms[current];
+		const FRoomPortals& portals = layer.Rooms[room];
+		const int32 slot = current - portals.FirstPortal;
+		const int32 count = portals.Tiles.Num();
+
+		// Step across the border
+		int32 partner = layer.PortalPartners[current];
+		if (partner != INDEX_NONE)
+			relax(partner, gCost + 1.0f, heuristic(layer.PortalTiles[partner]), current);
+
+		// Cross the room to its other portals
+		for (int32 j = 0; j < count; ++j)
+		{
+			uint16 distance = portals.Distances[slot * count + j];
+			if (j != slot && distance != Unreachable)
+				relax(portals.FirstPortal + j, gCost + distance, heuristic(portals.Tiles[j]), current);
+		}
+
+		// Walk to the target
+		if (room == endRoom)
+		{
+			uint16 distance = endDistances[graph.GetLocalIndex(portals.Tiles[slot])];
+			if (distance != Unreachable)
+				relax(goal, gCost + distance, 0.0f, current);
+		}
+	}
+	return false;
+}
+
+bool FDungeonRoomGraph::FindRoomPath(const FDungeonTileGraph& graph, int32 from, int32 to, int actorSize, TArray<int32>& outPath)
+{
+	outPath.Reset();
+	if (from == to || !CanEnter(graph, to, actorSize))
+		return false;
+
+	// Crossing a border
+	if (graph.GetRoom(from) != graph.GetRoom(to))
+	{
+		if (!IsAdjacent(graph, from, to))
+			return false;
+		outPath.Add(to);
+		return true;
+	}
+
+	uint16 distances[RoomTileCount];
+	int32 parents[RoomTileCount];
+	SearchRoom(graph, from, actorSize, distances, parents);
+	if (distances[graph.GetLocalIndex(to)] == Unreachable)
+		return false;
+
+	for (int32 current = to; current != from; current = parents[graph.GetLocalIndex(current)])
+		outPath.Add(current);
+	Algo::Reverse(outPath);
+	return true;
+}
@@ -0,0 +1,120 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DungeonTileGraph.h"
+
+class FDungeonPathContext;
+
+// A room-level route found by FDungeonRoomGraph, refined into tiles one segment at a time.
+struct DAMNATION_API FDungeonRoomRoute
+{
+	// The start tile, every portal tile passed through, then the target tile.
+	// Consecutive waypoints are either in the same room or on either side of a room border.
+	TArray<int32> Waypoints;
+	int ActorSize = 1;
+	// The waypoint the next refined segment ends on.
+	int32 NextWaypoint = 1;
+
+	void Reset()
+	{
+		Waypoints.Reset();
+		NextWaypoint = 1;
+	}
+
+	bool HasSegments() const { return NextWaypoint < Waypoints.Num(); }
+	int32 GetTarget() const { return Waypoints.Num() > 0 ? Waypoints.Last() : INDEX_NONE; }
+
+	// Appends the tiles of the next segment to outPath, excluding the tile it starts on.
+	// Returns false if the segment can no longer be walked, in which case the route should be replanned.
+	bool RefineNext(const FDungeonTileGraph& graph, TArray<int32>& outPath);
+
+	// Refines every remaining segment.
+	bool RefineAll(const FDungeonTileGraph& graph, TArray<int32>& outPath);
+};
+
+/*
+* Two level (HPA*) planner over the floor.
+* Each room is a cluster; wherever two rooms were stitched together by the macro grid, every contiguous run of connected
+* border tiles gets portal pairs at both ends & in the middle, so routes through wide openings don't detour to one crossing.
+* The steps between each pair of portals within a room are precomputed for each supported actor size, so long queries
+* become a search over a few hundred portals followed by refining room by room.
+* Each rooms' border links & per-room distances are only rebuilt when that rooms' topology version changes.
+*/
+class DAMNATION_API FDungeonRoomGraph
+{
+public:
+	// Actor sizes portals are built for. Other sizes use the next supported size up.
+	static const int32 LayerCount = 2;
+	static const int LayerSizes[LayerCount];
+
+	// Rebuilds the portals & any intra-room distances invalidated since the last update. Not thread-safe.
+	void Update(const FDungeonTileGraph& graph);
+
+	bool IsUpToDate(const FDungeonTileGraph& graph) const { return bBuilt && BuiltVersion == graph.GetTopologyVersion(); }
+
+	void Reset();
+
+	/*
+	* Finds a room-level route from start to end. Only reads the graph, so any number can run at once given their own contexts.
+	* Returns false if the graph is out of date, both tiles are in the same room, the actor size isn't supported or no route exists;
+	* callers should fall back to a flat search.
+	*/
+	bool FindRoute(const FDungeonTileGraph& graph, FDungeonPathContext& context, int32 start, int32 end, int actorSize, FDungeonRoomRoute& outRoute) const;
+
+	// Shortest path from one tile to another without leaving the rooms they're in. The tiles must share a room or be adjacent.
+	// Fills outPath from the tile after from up to & including to.
+	static bool FindRoomPath(const FDungeonTileGraph& graph, int32 from, int32 to, int actorSize, TArray<int32>& outPath);
+
+	int32 GetPortalCount(int actorSize) const;
+
+private:
+	// One rooms' portals for a single actor size.
+	struct FRoomPortals
+	{
+		TArray<int32> Tiles;
+		// Steps between each pair of portals without leaving the room, Tiles.Num() squared entries.
+		TArray<uint16> Distances;
+		// Room topology version the distances were built against.
+		uint32 Version = 0;
+		bool bValid = false;
+		// Index of the rooms' first portal in the layers' flat portal list.
+		int32 FirstPortal = 0;
+	};
+
+	struct FLayer
+	{
+		// Indexed by room
+		TArray<FRoomPortals> Rooms;
+		// Flat portal list, a portal is referred to by its index in these.
+		TArray<int32> PortalTiles;
+		TArray<int32> PortalRooms;
+		// The portal on the other side of the border.
+		TArray<int32> PortalPartners;
+	};
+
+	// A linked pair of tiles either side of a room border, A in the lower numbered room.
+	struct FBorderPair
+	{
+		int32 A;
+		int32 B;
+	};
+
+	// One rooms' links onto higher numbered rooms.
+	struct FRoomBorders
+	{
+		TArray<FBorderPair> Pairs;
+		// Room topology version the links were scanned at.
+		uint32 Version = 0;
+		bool bValid = false;
+	};
+
+	static int32 GetLayer(int actorSize);
+
+	// Indexed by room
+	TArray<FRoomBorders> RoomBorders;
+	FLayer Layers[LayerCount];
+	uint32 BuiltVersion = 0;
+	bool bBuilt = false;
+};
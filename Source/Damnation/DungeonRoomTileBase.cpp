@@ -4,16 +4,30 @@
 #include "DungeonRoomTileBase.h"
 #include "DungeonMacroGrid.h"
 #include "DamnationGameModeBase.h"
+#include "Engine/Texture2D.h"
+
+namespace
+{
+	bool IsInRoom(FVector2D position)
+	{
+		const int edge = ADungeonRoomTileBase::GridEdgeLength;
+		return !((int)position.X >= edge || (int)position.Y >= edge || position.X < 0 || position.Y < 0);
+	}
+}
 
 // Sets default values
 ADungeonRoomTileBase::ADungeonRoomTileBase()
 {
-	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+	// Respawns are woken by the game modes' scheduler, so rooms don't need to tick
+	PrimaryActorTick.bCanEverTick = false;
 
 	ValidCardinals.Init(true, 4);
+}
 
-	CurrentRespawnInterval = FMath::FRandRange(0.0f, RespawnInterval);
+void ADungeonRoomTileBase::SeedRandom(int32 seed)
+{
+	Random.Initialize(seed);
+	CurrentRespawnInterval = Random.FRandRange(0.0f, RespawnInterval);
 }
 
 // Called when the game starts or when spawned
@@ -30,51 +44,46 @@ void ADungeonRoomTileBase::PostInitializeComponents()
 
 	// Allocate space to be ready for additions
 	TileGridFlatArray.Init(nullptr, FlatArraySize);
+	TileIndices.Init(INDEX_NONE, FlatArraySize);
 }
 
-// Called every frame
-void ADungeonRoomTileBase::Tick(float DeltaTime)
+float ADungeonRoomTileBase::CheckRespawns(bool bPlayerActive, const FVector& playerLocation)
 {
-	Super::Tick(DeltaTime);
-	CurrentRespawnInterval -= DeltaTime;
-
-	if (CurrentRespawnInterval <= 0.0f)
+	// Shuffle spawn array
+	ShuffleArray(SpawnDataContainer.DataArray, Random);
+	if (bPlayerActive)
 	{
-		// Shuffle spawn array
-		ShuffleArray(SpawnDataContainer.DataArray);
-		auto gm = dynamic_cast<ADamnationGameModeBase*>(UGameplayStatics::GetGameMode(this));
-		if (gm && gm->ActivePlayer)
+		const float minDistanceSquared = FMath::Square(RespawnMinDistance);
+		for (auto spawnData : SpawnDataContainer.DataArray)
 		{
-			AActor* player = gm->ActivePlayer;
-			for (auto spawnData : SpawnDataContainer.DataArray)
+			if (RespawnCurrentCount <= 0)
+				break;
+			// Ensure the spawn is far enough away from the player, & that the spawn tile doesn't have something there already.
+			// Occupancy is read from the tile graph so spawn tiles don't need a proxy
+			float PlayerSpawnDistance = FVector::DistSquared(GetRoomTilePosition(spawnData.Spawn), playerLocation);
+			int32 spawnTile = GetTileIndex(spawnData.Spawn);
+			if (PlayerSpawnDistance >= minDistanceSquared && spawnTile != INDEX_NONE && MacroGrid && !MacroGrid->GetTileGraph().GetOccupant(spawnTile))
 			{
-				if (RespawnCurrentCount <= 0)
-					break;
-				// Ensure the spawn is far enough away from the player, & that the spawn tile doesn't have something there already.
-				float PlayerSpawnDistance = FVector::DistSquared(GetRoomTilePosition(spawnData.Spawn), player->GetActorLocation());
-				if (PlayerSpawnDistance >= FMath::Square(RespawnMinDistance) && !GetTile(spawnData.Spawn)->OccupyingActor)
-				{
-					SpawnEnemy(spawnData);
-					--RespawnCurrentCount;
-				}
+				SpawnEnemy(spawnData);
+				--RespawnCurrentCount;
 			}
 		}
-
-		// If enemies are still waiting to respawn, use a shorter delay between respawn checks.
-		if (RespawnCurrentCount > 0)
-			CurrentRespawnInterval = RespawnAwaitingInterval;
-		else CurrentRespawnInterval = RespawnInterval;
 	}
+
+	// If enemies are still waiting to respawn, use a shorter delay between respawn checks.
+	if (RespawnCurrentCount > 0)
+		CurrentRespawnInterval = RespawnAwaitingInterval;
+	else CurrentRespawnInterval = RespawnInterval;
+	return CurrentRespawnInterval;
 }
 
 ADungeonSingleTile* ADungeonRoomTileBase::ForceTileDisconnect(ECardinal direction, ADungeonSingleTile* targetTile)
 {
 	if (targetTile)
 	{
-		// Get accessor from ECardinal
-		uint8 accessor = (uint8)direction;
-		ADungeonSingleTile* hold = targetTile->CardinalConnections[accessor];
-		targetTile->CardinalConnections[accessor] = nullptr;
+		ADungeonSingleTile* hold = targetTile->GetAdjacent(direction);
+		targetTile->SetConnectedTile(direction, nullptr);
+		AssignSizes();
 		return hold;
 	}
 	else
@@ -87,7 +96,8 @@ void ADungeonRoomTileBase::ForceTileConnect(ECardinal direction, ADungeonSingleT
 {
 	if (targetTile)
 	{
-		targetTile->CardinalConnections[(uint8)direction] = linkingTile;
+		targetTile->SetConnectedTile(direction, linkingTile);
+		AssignSizes();
 	}
 }
 
@@ -95,22 +105,35 @@ void ADungeonRoomTileBase::SpawnEnemy(FEnemySpawnData& data)
 {
 	ADungeonCrawlerEnemy* enemy = dynamic_cast<ADungeonCrawlerEnemy*>(AddTileEntity(data.Type, data.Spawn));
 	enemy->OriginRoom = this;
+	enemy->SeedRepathInterval(Random);
 }
 
 void ADungeonRoomTileBase::SpawnEnemies(FEnemySpawnDataArrayContainer spawnInfo)
 {
 	SpawnDataContainer = spawnInfo;
-	int count = FMath::RandRange(EnemySpawnsMinimum, EnemySpawnsMaximum);
 	TArray<FEnemySpawnData>& dataRef = SpawnDataContainer.DataArray;
-	ShuffleArray(dataRef);
+	// Can't spawn more enemies than there are spawn points
+	int count = FMath::Min(Random.RandRange(EnemySpawnsMinimum, EnemySpawnsMaximum), dataRef.Num());
+	ShuffleArray(dataRef, Random);
 	for (int i = 0; i < count; ++i)
 	{
 		SpawnEnemy(dataRef[i]);
 	}
+
+	// Only rooms with spawns need waking to respawn
+	if (MacroGrid && MacroGrid->GetGamemode())
+		MacroGrid->GetGamemode()->ScheduleRespawnCheck(this, CurrentRespawnInterval);
 }
 
 ADungeonSingleTile* ADungeonRoomTileBase::AddTile(FVector2D position)
 {
+	if (MacroGrid)
+	{
+		AddTileData(position);
+		return GetTile(position);
+	}
+
+	// Off the macro grid there's no tile graph, so the tile is only an actor
 	ADungeonSingleTile* tileAtPosition = GetTile(position);
 	if (!tileAtPosition)
 	{
@@ -147,6 +170,43 @@ ADungeonSingleTile* ADungeonRoomTileBase::AddTile(FVector2D position)
 	return tileAtPosition;
 }
 
+int32 ADungeonRoomTileBase::AddTileData(FVector2D position)
+{
+	if (!IsInRoom(position))
+		return INDEX_NONE;
+	int32 tileAtPosition = GetTileIndex(position);
+	if (tileAtPosition != INDEX_NONE)
+	{
+		UE_LOG(LogTemp, Display, TEXT("AddTile attempted to place tile at position where a room already exists. Returning existing room."))
+		return tileAtPosition;
+	}
+
+	int index = GridToFlatIndex(position);
+	tileAtPosition = MacroGrid->RegisterTile(GetRoomTilePosition(position), RoomIndex, index);
+	TileIndices[index] = tileAtPosition;
+
+	int32 currentCheck = INDEX_NONE;
+	// Scan cardinals to add new connections + connect to this
+
+	// North of newTile
+	currentCheck = GetTileIndex(position + FVector2D(0, 1));
+	if (currentCheck != INDEX_NONE) MacroGrid->LinkTiles(tileAtPosition, ECardinal::NORTH, currentCheck, ECardinal::SOUTH);
+
+	// East of newTile
+	currentCheck = GetTileIndex(position + FVector2D(1, 0));
+	if (currentCheck != INDEX_NONE) MacroGrid->LinkTiles(tileAtPosition, ECardinal::EAST, currentCheck, ECardinal::WEST);
+
+	// South of newTile
+	currentCheck = GetTileIndex(position + FVector2D(-1, 0));
+	if (currentCheck != INDEX_NONE) MacroGrid->LinkTiles(tileAtPosition, ECardinal::SOUTH, currentCheck, ECardinal::NORTH);
+
+	// West of newTile
+	currentCheck = GetTileIndex(position + FVector2D(0, -1));
+	if (currentCheck != INDEX_NONE) MacroGrid->LinkTiles(tileAtPosition, ECardinal::WEST, currentCheck, ECardinal::EAST);
+
+	return tileAtPosition;
+}
+
 ADungeonTileOccupant* ADungeonRoomTileBase::AddTileEntity(TSubclassOf<ADungeonTileOccupant> type, FVector2D position)
 {
 	if (type)
@@ -180,30 +240,27 @@ int ADungeonRoomTileBase::GridToFlatIndex(FVector2D position)
 
 ADungeonSingleTile* ADungeonRoomTileBase::GetTile(FVector2D position)
 {
-	if ((int)position.X >= GridEdgeLength || (int)position.Y >= GridEdgeLength || position.X < 0 || position.Y < 0)
+	if (!IsInRoom(position))
 		return nullptr;
-	else return TileGridFlatArray[GridToFlatIndex(position)];
+	else return GetTileByIndex(GridToFlatIndex(position));
+}
+
+int32 ADungeonRoomTileBase::GetTileIndex(FVector2D position) const
+{
+	if (!IsInRoom(position))
+		return INDEX_NONE;
+	else return TileIndices[GridToFlatIndex(position)];
 }
 
 ADungeonSingleTile* ADungeonRoomTileBase::GetTileRandom(int size)
 {
-	// Make array of all Indices
-	TArray<uint32> possibleIndices;
-	possibleIndices.Init(0, RoomTileCount);
-	for (int i = 0; i < RoomTileCount; ++i)
-		possibleIndices[i] = i;
-	// Shuffle array so indices in array order 0..Num() act as a "random shuffle"
-	ShuffleArray<uint32>(possibleIndices);
-	// Iterate through indices from 0 to end and return the first valid result
-	ADungeonSingleTile* randTile;
-	for (int i = 0; i < RoomTileCount; ++i)
-	{
-		randTile = GetTileByIndex(possibleIndices[i]);
-		if (randTile && randTile->availableSpace >= size)
-			return randTile;
-	}
-	// This room has no valid tiles, return nullptr 
-	return nullptr;
+	// Tiles off the macro grid have no space assigned
+	if (!MacroGrid)
+		return nullptr;
+	// The tile graph keeps each rooms' tiles ordered by space, so this is a single draw
+	// Only the chosen tile needs a proxy
+	int32 randTile = MacroGrid->GetTileGraph().GetRandomRoomTile(RoomIndex, size, Random);
+	return randTile != INDEX_NONE ? MacroGrid->GetTileProxy(randTile) : nullptr;
 }
 
 FVector ADungeonRoomTileBase::GetRoomTilePosition(FVector2D position)
@@ -215,69 +272,198 @@ ADungeonSingleTile* ADungeonRoomTileBase::GetTileByIndex(int index)
 {
 	if (index < 0 || index >= FlatArraySize)
 		return nullptr;
+	// Spawns the tiles' proxy the first time it's asked for
+	if (MacroGrid && TileIndices[index] != INDEX_NONE)
+		return MacroGrid->GetTileProxy(TileIndices[index]);
 	else return TileGridFlatArray[index];
 }
 
-void swap(FColor* a, FColor* b)
+bool FDungeonRoomLayout::Decode(UTexture2D* texture)
+{
+	const int32 edge = ADungeonRoomTileBase::GridEdgeLength;
+	Palette.Reset();
+	Pixels.Reset();
+	if (!texture || !texture->PlatformData || texture->PlatformData->Mips.Num() == 0)
+		return false;
+	const int32 sizeX = texture->GetSizeX();
+	const int32 sizeY = texture->GetSizeY();
+	if (sizeX > edge || sizeY > edge)
+		return false;
+
+	FByteBulkData& bulkData = texture->PlatformData->Mips[0].BulkData;
+	const FColor* MapDataPixels = static_cast<const FColor*>(bulkData.LockReadOnly());
+	if (!MapDataPixels)
+	{
+		bulkData.Unlock();
+		return false;
+	}
+
+	Pixels.Init(NoColor, ADungeonRoomTileBase::RoomTileCount);
+	for (int32 x = 0; x < edge; ++x)
+		for (int32 y = 0; y < edge; ++y)
+		{
+			// Texture rows run top to bottom, so are flipped to have row 0 on the bottom
+			int32 row = edge - 1 - x;
+			if (row >= sizeY || y >= sizeX)
+				continue;
+			FColor pixelColor = MapDataPixels[row * sizeX + y];
+			int32 entry = Palette.Find(pixelColor);
+			if (entry == INDEX_NONE)
+				entry = Palette.Add(pixelColor);
+			Pixels[x * edge + y] = (uint8)entry;
+		}
+
+	bulkData.Unlock();
+	return true;
+}
+
+const FDungeonRoomLayout& ADungeonRoomTileBase::GetLayout() const
+{
+	// Every room of a class shares its defaults' layout, so each class is decoded at most once
+	ADungeonRoomTileBase* defaults = GetClass()->GetDefaultObject<ADungeonRoomTileBase>();
+	if (!defaults->CookedLayout.IsValid() && defaults->MapTexture)
+		defaults->CookedLayout.Decode(defaults->MapTexture);
+	return defaults->CookedLayout;
+}
+
+#if WITH_EDITOR
+void ADungeonRoomTileBase::PreSave(const ITargetPlatform* TargetPlatform)
 {
-	FColor temp = *a;
-	*a = *b;
-	*b = temp;
+	Super::PreSave(TargetPlatform);
+	// Store the decoded texture with the class defaults, so cooked builds never need the texture data
+	if (HasAnyFlags(RF_ClassDefaultObject))
+	{
+		CookedLayout = FDungeonRoomLayout();
+		if (MapTexture)
+			CookedLayout.Decode(MapTexture);
+	}
 }
 
+void ADungeonRoomTileBase::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+	// Decoded again on next use
+	if (PropertyChangedEvent.GetPropertyName() == GET_MEMBER_NAME_CHECKED(ADungeonRoomTileBase, MapTexture))
+		CookedLayout = FDungeonRoomLayout();
+}
+#endif // WITH_EDITOR
+
 void ADungeonRoomTileBase::LoadTextureToMap()
 {
-	const TMap<FColor, ADamnationGameModeBase::FTileColorSpawn>& colorMap = MacroGrid->GetGamemode()->ColorDelegateMap;
+	ADamnationGameModeBase* gamemode = MacroGrid->GetGamemode();
 
-	if (!MapTexture) return;
-	if (MapTexture->GetSizeX() > GridEdgeLength || MapTexture->GetSizeY() > GridEdgeLength) return;
+	const FDungeonRoomLayout& layout = GetLayout();
+	if (!layout.IsValid()) return;
 
-	const FColor* MapDataPixels = static_cast<const FColor*>(MapTexture->PlatformData->Mips[0].BulkData.LockReadOnly());
+	// Look up each colour once rather than once per tile. Native actions take priority over delegates.
+	TArray<const FTileColorAction*, TInlineAllocator<16>> actions;
+	TArray<const ADamnationGameModeBase::FTileColorSpawn*, TInlineAllocator<16>> callbacks;
+	for (const FColor& color : layout.Palette)
+	{
+		const FTileColorAction* action = gamemode->NativeColorMap.Find(color);
+		actions.Add(action);
+		callbacks.Add(action ? nullptr : gamemode->ColorDelegateMap.Find(color));
+	}
 
-	FColor FlippedTextureData[GridEdgeLength][GridEdgeLength];
+	// Every native colour is a tile, so add them all before any spawns or delegates run
+	TArray<TPair<const FTileColorAction*, FVector2D>, TInlineAllocator<16>> spawns;
 	for (int32 x = 0; x < GridEdgeLength; ++x)
 		for (int32 y = 0; y < GridEdgeLength; ++y)
-			FlippedTextureData[x][y] = MapDataPixels[x * MapTexture->GetSizeX() + y];
-
-	MapTexture->PlatformData->Mips[0].BulkData.Unlock();
+		{
+			uint8 entry = layout.Pixels[x * GridEdgeLength + y];
+			if (entry == FDungeonRoomLayout::NoColor || !actions[entry])
+				continue;
+			AddTileData(FVector2D(x, y));
+			if (actions[entry]->Action != ETileColorAction::ADDTILE)
+				spawns.Add(TPair<const FTileColorAction*, FVector2D>(actions[entry], FVector2D(x, y)));
+		}
 
-	for (int i = 0; i < GridEdgeLength; ++i)
+	FEnemySpawnDataArrayContainer enemySpawns;
+	for (const TPair<const FTileColorAction*, FVector2D>& spawn : spawns)
 	{
-		int start = 0;
-		int end = GridEdgeLength - 1;
-		while (start < end)
+		switch (spawn.Key->Action)
 		{
-			swap(&FlippedTextureData[start][i], &FlippedTextureData[end][i]);
-			start++;
-			end--;
+		case ETileColorAction::ENEMYSPAWN:
+			if (spawn.Key->EnemyType)
+			{
+				FEnemySpawnData data;
+				data.Spawn = spawn.Value;
+				data.Type = spawn.Key->EnemyType;
+				enemySpawns.DataArray.Add(data);
+			}
+			break;
+		case ETileColorAction::EYESPAWN:
+			gamemode->AddEyeLocation(this, spawn.Value);
+			break;
+		case ETileColorAction::TORMENTORSPAWN:
+			gamemode->AddTormentorLocation(GetTile(spawn.Value));
+			break;
+		case ETileColorAction::PLAYERSPAWN:
+			if (gamemode->ActivePlayer)
+				gamemode->SetPlayerLocation(GetTile(spawn.Value));
+			break;
+		default:
+			break;
 		}
 	}
 
+	// Custom colours
 	for (int32 x = 0; x < GridEdgeLength; ++x)
 		for (int32 y = 0; y < GridEdgeLength; ++y)
 		{
-			FColor pixelColor = FlippedTextureData[x][y];
-			auto test = colorMap.Find(pixelColor);
-			if (test)
-				test->Execute(this, FVector2D(x, y));
+			uint8 entry = layout.Pixels[x * GridEdgeLength + y];
+			if (entry != FDungeonRoomLayout::NoColor && callbacks[entry])
+				callbacks[entry]->Execute(this, FVector2D(x, y));
 		}
 
+	if (enemySpawns.DataArray.Num() > 0)
+		SpawnEnemies(enemySpawns);
+
+	if (bSpawnTileProxies)
+		for (int32 tile : TileIndices)
+			if (tile != INDEX_NONE)
+				MacroGrid->GetTileProxy(tile);
+
 	// Map has been loaded, call map loaded event for blueprint visual implementations
 	OnMapLoad();
 }
 
 void ADungeonRoomTileBase::AssignSizes()
 {
-	for (auto tile : TileGridFlatArray)
-		if (tile)
-			tile->availableSpace = (tile->CheckSurroundingTiles()) ? 3 : 1;
+	// Space is maintained by the floors' tile graph, only the tiles changed since the last update are recomputed
+	if (MacroGrid)
+		MacroGrid->UpdateClearance();
 }
 
 void ADungeonRoomTileBase::DestroyRoom()
 {
 	for (auto tile : TileGridFlatArray)
 		if (tile)
-			tile->Destroy();
+		{
+			if (MacroGrid)
+				MacroGrid->ReleaseTile(tile);
+			else
+				tile->Destroy();
+		}
 	Destroy();
 }
 
+void ADungeonRoomTileBase::ResetRoom()
+{
+	for (ADungeonSingleTile*& tile : TileGridFlatArray)
+	{
+		if (tile && MacroGrid)
+			MacroGrid->ReleaseTile(tile);
+		else if (tile)
+			tile->Destroy();
+		tile = nullptr;
+	}
+	TileIndices.Init(INDEX_NONE, FlatArraySize);
+	SpawnDataContainer.DataArray.Empty();
+	RespawnCurrentCount = 0;
+	if (MacroGrid && MacroGrid->GetGamemode())
+		MacroGrid->GetGamemode()->CancelRespawnCheck(this);
+	RoomIndex = INDEX_NONE;
+	OnRoomReset();
+}
+
@@ -42,6 +42,29 @@ public:
 	TArray<FEnemySpawnData> DataArray;
 };
 
+// A room map texture decoded into its distinct colours, so rooms can be loaded without reading texture data.
+USTRUCT()
+struct FDungeonRoomLayout
+{
+	GENERATED_BODY()
+
+public:
+	static const uint8 NoColor = 255;
+
+	// Each distinct colour in the texture, in the order first found.
+	UPROPERTY()
+	TArray<FColor> Palette;
+
+	// Palette index of every tile position, flat in the same order as the rooms' tile array. NoColor outside the texture.
+	UPROPERTY()
+	TArray<uint8> Pixels;
+
+	bool IsValid() const { return Pixels.Num() > 0; }
+
+	// Decodes the first mip of a room map texture. Returns false if it's too large or its data isn't available.
+	bool Decode(UTexture2D* texture);
+};
+
 UCLASS()
 class DAMNATION_API ADungeonRoomTileBase : public AActor
 {
@@ -51,9 +74,6 @@ public:
 	// Sets default values for this actor's properties
 	ADungeonRoomTileBase();
 
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
-	
 	const static int GridEdgeLength = 15;
 	const static int RoomTileCount = GridEdgeLength * GridEdgeLength;
 	const static int TileSeparation = 100;
@@ -62,8 +82,8 @@ public:
 	// Helper to simplify cardinal setting
 	inline static void CheckSetCardinal(int arrayPosA, int arrayPosB, ADungeonSingleTile* tileA, ADungeonSingleTile* tileB)
 	{
-		tileA->CardinalConnections[arrayPosA] = tileB;
-		tileB->CardinalConnections[arrayPosB] = tileA;
+		tileA->SetConnectedTile((ECardinal)arrayPosA, tileB);
+		tileB->SetConnectedTile((ECardinal)arrayPosB, tileA);
 	}
 
 	// Forcefully unlinks a given tile from the direction. Should be avoided unless necessary.
@@ -94,12 +114,28 @@ public:
 	UFUNCTION(BlueprintImplementableEvent, Category = "RoomTileBase")
 	void OnEnemyDeath();
 
+	// Respawns waiting enemies on spawns far enough from the player & unoccupied. Returns the delay until the next check.
+	// Called by the game modes' respawn scheduler once the rooms' current interval is up; bPlayerActive is false if there's no player.
+	float CheckRespawns(bool bPlayerActive, const FVector& playerLocation);
+
 	UFUNCTION(BlueprintCallable)
 	void SetMacroGrid(ADungeonMacroGrid* grid) { MacroGrid = grid; }
 
+	// Seeds the rooms' random stream & picks its first respawn check delay. Called by the macro grid when spawned.
+	void SeedRandom(int32 seed);
+
+	// The rooms' flat index on the macro grid, tiles are registered to the floor under this room.
+	void SetRoomIndex(int32 index) { RoomIndex = index; }
+	int32 GetRoomIndex() const { return RoomIndex; }
+
+	// Adds a tile & returns its proxy actor.
 	UFUNCTION(BlueprintCallable)
 	ADungeonSingleTile* AddTile(FVector2D position);
 
+	// Adds a tile to the floors' tile graph without spawning an actor for it & returns its tile index.
+	// Only valid once the room is on a macro grid.
+	int32 AddTileData(FVector2D position);
+
 	UFUNCTION(BlueprintCallable)
 	ADungeonTileOccupant* AddTileEntity(TSubclassOf<ADungeonTileOccupant> type, FVector2D position);
 
@@ -115,9 +151,16 @@ public:
 	UFUNCTION(BlueprintPure)
 	static int GridToFlatIndex(FVector2D position);
 
+	// Gets the tile at position, spawning its proxy actor if it has none yet.
 	UFUNCTION(BlueprintPure)
 	ADungeonSingleTile* GetTile(FVector2D position);
 
+	// The floor tile index of the tile at position, INDEX_NONE if there's no tile.
+	int32 GetTileIndex(FVector2D position) const;
+
+	// Stores the proxy spawned for the tile at localIndex. Called by the macro grid.
+	void SetTileProxy(int32 localIndex, ADungeonSingleTile* tile) { TileGridFlatArray[localIndex] = tile; }
+
 	// Gets a random valid tile from this room. Optionally supply a size requirement for the tile to fit a specific entity.
 	UFUNCTION(BlueprintPure)
 	ADungeonSingleTile* GetTileRandom(int size = 1);
@@ -132,12 +175,30 @@ public:
 	UFUNCTION(BlueprintCallable)
 	void LoadTextureToMap();
 
+	// Brings the available space of changed tiles up to date. Called automatically once a room has been added & connected.
 	UFUNCTION(BlueprintCallable)
 	void AssignSizes();
 
 	UFUNCTION()
 	void DestroyRoom();
 
+	// Returns the rooms' tiles to the macro grids' pool & clears its floor state so the room can be reused. Only for poolable rooms.
+	void ResetRoom();
+
+	// Called when the room is reset for reuse. Must undo anything OnMapLoad & OnMapFinalization added.
+	UFUNCTION(BlueprintImplementableEvent, Category = "RoomTileBase")
+	void OnRoomReset();
+
+	// Whether the room can be kept & reused by later floors instead of destroyed.
+	// Only enable if OnRoomReset undoes everything the room's Blueprint adds when loaded.
+	UPROPERTY(EditDefaultsOnly, Category = "Dungeon Room Data")
+	bool bPoolable = false;
+
+	// Whether every tile gets a proxy actor before OnMapLoad. Only enable for room Blueprints reading TileGridFlatArray,
+	// otherwise tiles are data only until something asks for their actor.
+	UPROPERTY(EditDefaultsOnly, Category = "Dungeon Room Data")
+	bool bSpawnTileProxies = false;
+
 	// The cardinal directions this room is able to connect to.
 	// Only elements 0-3 will ever be read, thus the array size shouldn't be modified.
 	// Each bool is evaluated clockwise (0 == North, 1 == East...)
@@ -157,6 +218,15 @@ public:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Dungeon Room Data")
 	UTexture2D* MapTexture;
 
+	// MapTexture decoded, shared by every room of the class. Cooked into the class defaults when saved in the editor,
+	// otherwise decoded the first time a room of the class is loaded.
+	const FDungeonRoomLayout& GetLayout() const;
+
+#if WITH_EDITOR
+	virtual void PreSave(const class ITargetPlatform* TargetPlatform) override;
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif // WITH_EDITOR
+
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
@@ -168,10 +238,17 @@ protected:
 	UPROPERTY()
 	FEnemySpawnDataArrayContainer SpawnDataContainer;
 
-	// 2D array of tiles for movement
+	// Only read from the class default object, see GetLayout
+	UPROPERTY()
+	FDungeonRoomLayout CookedLayout;
+
+	// 2D array of tiles' proxy actors, nullptr until one is spawned. See bSpawnTileProxies.
 	UPROPERTY(BlueprintReadOnly)
 	TArray<ADungeonSingleTile*> TileGridFlatArray;
 
+	// 2D array of tiles for movement, as indices into the floors' tile graph. INDEX_NONE where there's no tile.
+	TArray<int32> TileIndices;
+
 	// The minimum amount of enemies that can be spawned in this room.
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Dungeon Room Data")
 	int EnemySpawnsMinimum = 0;
@@ -191,6 +268,7 @@ protected:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Dungeon Room Data")
 	float RespawnAwaitingInterval = 10.0f;
 
+	// The delay the rooms' next respawn check was scheduled with.
 	UPROPERTY(VisibleAnywhere, Category = "Dungeon Room Data")
 	float CurrentRespawnInterval = 0.0f;
 
@@ -200,4 +278,9 @@ protected:
 
 	UPROPERTY(BlueprintReadOnly)
 	ADungeonMacroGrid* MacroGrid;
+
+	int32 RoomIndex = INDEX_NONE;
+
+	// Enemy spawns, respawns & random tiles
+	FRandomStream Random;
 };
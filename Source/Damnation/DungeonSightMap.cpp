@@ -0,0 +1,161 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DungeonSightMap.h"
+#include "DungeonRoomTileBase.h"
+#include "Algo/BinarySearch.h"
+
+namespace
+{
+	const int32 Edge = ADungeonRoomTileBase::GridEdgeLength;
+	const FIntPoint NoCell(INDEX_NONE, INDEX_NONE);
+}
+
+void FDungeonSightMap::Init(const FVector& origin, int32 roomsX, int32 roomsY)
+{
+	Origin = origin;
+	RoomsX = FMath::Max(roomsX, 0);
+	RoomsY = FMath::Max(roomsY, 0);
+	Reset();
+}
+
+void FDungeonSightMap::Reset()
+{
+	RoomSlots.Init(INDEX_NONE, RoomsX * RoomsY);
+	Rooms.Reset();
+	TileCells.Reset();
+	ClearVisibleSets();
+	++Version;
+}
+
+void FDungeonSightMap::AddTile(int32 tile, const FVector& location)
+{
+	if (tile < 0)
+		return;
+	// Tiles are registered in index order, so this is normally a single add
+	while (TileCells.Num() <= tile)
+		TileCells.Add(NoCell);
+
+	FIntPoint cell(FMath::FloorToInt((location.X - Origin.X) / ADungeonRoomTileBase::TileSeparation),
+		FMath::FloorToInt((location.Y - Origin.Y) / ADungeonRoomTileBase::TileSeparation));
+	if (cell.X < 0 || cell.Y < 0 || cell.X >= RoomsX * Edge || cell.Y >= RoomsY * Edge)
+		return;
+
+	int32& slot = RoomSlots[(cell.Y / Edge) * RoomsX + cell.X / Edge];
+	if (slot == INDEX_NONE)
+	{
+		slot = Rooms.AddDefaulted();
+		Rooms[slot].Tiles.Init(INDEX_NONE, ADungeonRoomTileBase::RoomTileCount);
+	}
+	FRoomCells& room = Rooms[slot];
+	const int32 local = (cell.Y % Edge) * Edge + cell.X % Edge;
+	room.OpenMask[local / 64] |= 1ull << (local % 64);
+	room.Tiles[local] = tile;
+	TileCells[tile] = cell;
+
+	ClearVisibleSets();
+	++Version;
+}
+
+int32 FDungeonSightMap::GetRoomSlot(const FIntPoint& cell) const
+{
+	if (cell.X < 0 || cell.Y < 0 || cell.X >= RoomsX * Edge || cell.Y >= RoomsY * Edge)
+		return INDEX_NONE;
+	return RoomSlots[(cell.Y / Edge) * RoomsX + cell.X / Edge];
+}
+
+bool FDungeonSightMap::IsOpen(const FIntPoint& cell) const
+{
+	const int32 slot = GetRoomSlot(cell);
+	if (slot == INDEX_NONE)
+		return false;
+	const int32 local = (cell.Y % Edge) * Edge + cell.X % Edge;
+	return (Rooms[slot].OpenMask[local / 64] >> (local % 64)) & 1;
+}
+
+int32 FDungeonSightMap::GetTileAt(const FIntPoint& cell) const
+{
+	const int32 slot = GetRoomSlot(cell);
+	return slot == INDEX_NONE ? INDEX_NONE : Rooms[slot].Tiles[(cell.Y % Edge) * Edge + cell.X % Edge];
+}
+
+bool FDungeonSightMap::IsLineClear(FIntPoint a, FIntPoint b) const
+{
+	if (a == b)
+		return true;
+	// Bresenham steps differently depending on which end it starts from, so always start from the same one
+	if (b.X < a.X || (b.X == a.X && b.Y < a.Y))
+		Swap(a, b);
+
+	const int32 dx = FMath::Abs(b.X - a.X);
+	const int32 dy = -FMath::Abs(b.Y - a.Y);
+	const int32 sx = a.X < b.X ? 1 : -1;
+	const int32 sy = a.Y < b.Y ? 1 : -1;
+	int32 error = dx + dy;
+	FIntPoint cell = a;
+	while (true)
+	{
+		const int32 error2 = error * 2;
+		if (error2 >= dy)
+		{
+			error += dy;
+			cell.X += sx;
+		}
+		if (error2 <= dx)
+		{
+			error += dx;
+			cell.Y += sy;
+		}
+		if (cell == b)
+			return true;
+		if (!IsOpen(cell))
+			return false;
+	}
+}
+
+bool FDungeonSightMap::HasLineOfSight(int32 from, int32 to) const
+{
+	if (!TileCells.IsValidIndex(from) || !TileCells.IsValidIndex(to) || TileCells[from] == NoCell || TileCells[to] == NoCell)
+		return false;
+	return IsLineClear(TileCells[from], TileCells[to]);
+}
+
+const TArray<int32>& FDungeonSightMap::GetVisibleTiles(int32 origin, int32 radius)
+{
+	if (VisibleSets.Num() >= MaxCachedSets && !VisibleSets.Contains(origin))
+		ClearVisibleSets();
+	FVisibleSet& set = VisibleSets.FindOrAdd(origin);
+	if (set.Radius == radius)
+		return set.Tiles;
+
+	set.Radius = radius;
+	set.Tiles.Reset();
+	if (!TileCells.IsValidIndex(origin) || TileCells[origin] == NoCell || radius < 0)
+		return set.Tiles;
+
+	// Every cell holding a tile is open, so only those need a trace
+	const FIntPoint centre = TileCells[origin];
+	for (int32 y = -radius; y <= radius; ++y)
+		for (int32 x = -radius; x <= radius; ++x)
+		{
+			if (x * x + y * y > radius * radius)
+				continue;
+			const FIntPoint cell = centre + FIntPoint(x, y);
+			const int32 tile = GetTileAt(cell);
+			if (tile != INDEX_NONE && IsLineClear(centre, cell))
+				set.Tiles.Add(tile);
+		}
+	set.Tiles.Sort();
+	return set.Tiles;
+}
+
+bool FDungeonSightMap::IsVisibleFrom(int32 origin, int32 tile, int32 radius)
+{
+	return Algo::BinarySearch(GetVisibleTiles(origin, radius), tile) != INDEX_NONE;
+}
+
+void FDungeonSightMap::ClearVisibleSets()
+{
+	// Cheap to call while generating, the cache is only filled once queries start
+	if (VisibleSets.Num() > 0)
+		VisibleSets.Reset();
+}
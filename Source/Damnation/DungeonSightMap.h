@@ -0,0 +1,83 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/*
+* Line of sight on the tile grid, without physics.
+* Every room of the macro grid keeps a mask of which of its cells hold a tile; any cell without one is a wall.
+* Sight lines are traced cell to cell with Bresenham, always from the lesser end, so a sees b exactly when b sees a.
+* Visible sets are cached per origin tile until a tile is added or the map is reset, so any number of occupants
+* & the fog of war can ask what's visible from the same tile for the cost of one trace per cell.
+* Not thread-safe, only used on the game thread.
+*/
+class DAMNATION_API FDungeonSightMap
+{
+public:
+	// Visible sets kept before the cache is cleared
+	static const int32 MaxCachedSets = 256;
+
+	// Sizes the map for a grid of roomsX by roomsY rooms, whose cell (0, 0) starts at origin. Clears every tile.
+	void Init(const FVector& origin, int32 roomsX, int32 roomsY);
+
+	// Clears every tile, keeping the size.
+	void Reset();
+
+	// Opens the cell at the tiles' location. Called as tiles are registered, tile being its index in the tile graph.
+	void AddTile(int32 tile, const FVector& location);
+
+	// Whether cell holds a tile. Cells off the map are walls.
+	bool IsOpen(const FIntPoint& cell) const;
+
+	// The tile index in cell, INDEX_NONE if it's a wall.
+	int32 GetTileAt(const FIntPoint& cell) const;
+
+	// Whether no wall lies between the centres of two tiles. False if either tile isn't on the map.
+	bool HasLineOfSight(int32 from, int32 to) const;
+
+	// Every tile within radius cells of origin (inclusive) with a clear line of sight to it, including origin, sorted by tile index.
+	// The array is cached & shared; it stays valid until the next call to GetVisibleTiles, AddTile or Reset.
+	const TArray<int32>& GetVisibleTiles(int32 origin, int32 radius);
+
+	// Whether tile is within radius of origin & visible from it, using the cached visible set of origin.
+	bool IsVisibleFrom(int32 origin, int32 tile, int32 radius);
+
+	// Bumped whenever a tile is added or the map is reset.
+	uint32 GetVersion() const { return Version; }
+
+private:
+	// Whether every cell strictly between a & b is open.
+	bool IsLineClear(FIntPoint a, FIntPoint b) const;
+
+	// The rooms' slot in Rooms, INDEX_NONE if the room has no tiles or cell is off the map.
+	int32 GetRoomSlot(const FIntPoint& cell) const;
+
+	void ClearVisibleSets();
+
+	struct FRoomCells
+	{
+		// Bit n set if cell n holds a tile, cells indexed the same as a rooms' tiles (y * GridEdgeLength + x)
+		uint64 OpenMask[4] = {};
+		// Tile index in each cell
+		TArray<int32> Tiles;
+	};
+
+	struct FVisibleSet
+	{
+		int32 Radius = -1;
+		TArray<int32> Tiles;
+	};
+
+	FVector Origin = FVector::ZeroVector;
+	int32 RoomsX = 0;
+	int32 RoomsY = 0;
+	// Index into Rooms for every room of the grid, INDEX_NONE until it has a tile
+	TArray<int32> RoomSlots;
+	TArray<FRoomCells> Rooms;
+	// Cell of each tile, indexed by tile index. (INDEX_NONE, INDEX_NONE) if off the map.
+	TArray<FIntPoint> TileCells;
+
+	TMap<int32, FVisibleSet> VisibleSets;
+	uint32 Version = 0;
+};
@@ -38,80 +38,24 @@ void ADungeonSingleTile::Tick(float DeltaTime)
 
 bool ADungeonSingleTile::CheckSurroundingTiles()
 {
-	for (int i = 0; i < 4; ++i)
-	{
-		if (!CardinalConnections[i] || CardinalConnections[i]->bPathingIgnore)
-			return false;
-
-		if (i % 2 == 0)
-			if (!CardinalConnections[i]->CardinalConnections[1] ||
-				!CardinalConnections[i]->CardinalConnections[3] ||
-				CardinalConnections[i]->CardinalConnections[1]->bPathingIgnore ||
-				CardinalConnections[i]->CardinalConnections[3]->bPathingIgnore
-				)
-				return false;
-	}
-	return true;
+	return Graph ? Graph->CheckSurroundingTiles(TileIndex) : false;
 }
 
 ADungeonSingleTile* ADungeonSingleTile::GetConnectedTile(ECardinal Direction)
 {
-	return CardinalConnections[(uint8)Direction];
+	return GetAdjacent(Direction);
 }
 
 void ADungeonSingleTile::GetSurroundingTiles(TArray<ADungeonSingleTile*>& tiles)
 {
-	tiles.Empty(9);
-	// Trackers for tiles outside of this tiles' direct influence
-	ADungeonSingleTile* tl = nullptr;
-	ADungeonSingleTile* tr = nullptr;
-	ADungeonSingleTile* bl = nullptr;
-	ADungeonSingleTile* br = nullptr;
-
-	for (int i = 0; i < 4; ++i)
-	{
-		auto current = CardinalConnections[i];
-
-		tiles.Add(current);
-
-		if (current)
-		{
-			if (i % 2 == 0)
-			{
-				ADungeonSingleTile* left = current->CardinalConnections[3];
-				ADungeonSingleTile* right = current->CardinalConnections[1];
-				if (i == 0)
-				{
-					tl = tl ? tl : left;
-					tr = tr ? tr : right;
-				}
-				else
-				{
-					bl = bl ? bl : left;
-					br = br ? br : right;
-				}
-			}
-			else if (i % 2 != 0)
-			{
-				ADungeonSingleTile* up = current->CardinalConnections[0];
-				ADungeonSingleTile* down = current->CardinalConnections[2];
-				if (i == 1)
-				{
-					tr = tr ? tr : up;
-					br = br ? br : down;
-				}
-				else
-				{
-					tl = tl ? tl : up;
-					bl = bl ? bl : down;
-				}
-			}
-		}
-	}
-	tiles.Add(tl);
-	tiles.Add(tr);
-	tiles.Add(br);
-	tiles.Add(bl);
+	tiles.Init(nullptr, 8);
+	if (!Graph)
+		return;
+
+	int32 surrounding[8];
+	Graph->GetSurroundingTiles(TileIndex, surrounding);
+	for (int i = 0; i < 8; ++i)
+		tiles[i] = Graph->GetTile(surrounding[i]);
 }
 
 TArray<ECardinal> ADungeonSingleTile::MakeRandDirectionArray()
@@ -126,6 +70,51 @@ TArray<ECardinal> ADungeonSingleTile::MakeRandDirectionArray()
 
 ADungeonSingleTile* ADungeonSingleTile::GetAdjacent(ECardinal direction)
 {
+	// The neighbour may not have a proxy yet
+	if (Graph)
+		return Graph->GetTile(Graph->GetNeighbour(TileIndex, (int32)direction));
 	return CardinalConnections[(uint32)direction];
 }
 
+
+
+void ADungeonSingleTile::SetConnectedTile(ECardinal direction, ADungeonSingleTile* tile)
+{
+	CardinalConnections[(uint8)direction] = tile;
+	if (Graph)
+		Graph->SetConnection(TileIndex, (int32)direction, tile ? tile->TileIndex : INDEX_NONE);
+}
+
+void ADungeonSingleTile::SyncConnections()
+{
+	if (!Graph)
+		return;
+	for (int32 dir = 0; dir < FDungeonTileGraph::CardinalCount; ++dir)
+		CardinalConnections[dir] = Graph->FindTile(Graph->GetNeighbour(TileIndex, dir));
+}
+
+void ADungeonSingleTile::ResetTile()
+{
+	CardinalConnections.Init(nullptr, 4);
+	OccupyingActor = nullptr;
+	TileEvent.Clear();
+	Graph = nullptr;
+	TileIndex = INDEX_NONE;
+}
+
+void ADungeonSingleTile::SetOccupyingActor(AActor* actor)
+{
+	OccupyingActor = actor;
+	if (Graph)
+		Graph->SetOccupant(TileIndex, FDungeonTileGraph::MakeOccupantHandle(actor));
+}
+
+void ADungeonSingleTile::PermitPathing(bool AllowPathing)
+{
+	if (!Graph)
+		return;
+
+	Graph->SetPathingIgnored(TileIndex, !AllowPathing);
+	// Spread the change in space out to the tiles around this one
+	Graph->UpdateClearance();
+}
@@ -7,6 +7,7 @@
 #include "UObject/ConstructorHelpers.h"
 #include "Engine/StaticMesh.h"
 #include "Components/StaticMeshComponent.h"
+#include "DungeonTileGraph.h"
 
 // DEBUG PURPOSES
 #if !UE_BUILD_SHIPPING
@@ -44,6 +45,26 @@ static void ShuffleArray(TArray<T>& arr)
 	}
 }
 
+// Shuffle drawing from a random stream, so the result can be reproduced from its seed
+template <class T>
+static void ShuffleArray(TArray<T>& arr, FRandomStream& stream)
+{
+	if (arr.Num() > 0)
+	{
+		int32 lastIDX = arr.Num() - 1;
+		for (int32 i = 0; i <= lastIDX; ++i)
+		{
+			int32 idx = stream.RandRange(i, lastIDX);
+			if (i != idx)
+				arr.Swap(i, idx);
+		}
+	}
+}
+
+/*
+* Actor proxy for a tile in the floors' FDungeonTileGraph, which holds the tiles' actual data.
+* Only spawned for tiles that Blueprint or gameplay code asks for, see ADungeonMacroGrid::GetTileProxy.
+*/
 UCLASS()
 class DAMNATION_API ADungeonSingleTile : public AActor
 {
@@ -61,7 +82,7 @@ public:
 	UFUNCTION(BlueprintPure)
 	bool CheckSurroundingTiles();
 
-	// Get reference to connected tile in direction
+	// Get reference to connected tile in direction, spawning its proxy if needed
 	// Null if no tile is connected in that direction
 	UFUNCTION(BlueprintPure)
 	ADungeonSingleTile* GetConnectedTile(ECardinal Direction);
@@ -88,6 +109,15 @@ public:
 	UFUNCTION(BlueprintPure)
 	ADungeonSingleTile* GetAdjacent(ECardinal direction);
 
+	// Sets the connection in the given direction, keeping the tile graph in sync. One-way; nullptr clears the connection.
+	void SetConnectedTile(ECardinal direction, ADungeonSingleTile* tile);
+
+	// Refreshes CardinalConnections from the tile graph.
+	void SyncConnections();
+
+	// Mirror of the connections stored in the tile graph, kept for Blueprint access.
+	// Only holds tiles whose proxy has been spawned; GetConnectedTile reaches every tile.
+	// Modify through SetConnectedTile.
 	UPROPERTY(BlueprintReadOnly)
 	TArray<ADungeonSingleTile*> CardinalConnections;
 
@@ -95,9 +125,13 @@ public:
 	//UTextRenderComponent* DEBUG_IndexText;
 
 	// The actor currently occupying this tile. Nullptr if none
-	UPROPERTY(BlueprintReadWrite)
+	UPROPERTY(BlueprintReadWrite, BlueprintSetter = SetOccupyingActor)
 	AActor* OccupyingActor = nullptr;
 
+	// Sets the occupying actor, keeping the tile graph in sync.
+	UFUNCTION(BlueprintSetter)
+	void SetOccupyingActor(AActor* actor);
+
 	// UDELEGATE(BlueprintAuthorityOnly)
 	DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FTileEventCall, AActor*, Occupant, ADungeonSingleTile*, TriggeredTile);
 
@@ -105,41 +139,32 @@ public:
 	FTileEventCall TileEvent;
 
 	// Tells pathfinding this tile is usable for any pathfinding
-	// Also adjusts nearby tiles to account for this tiles' impassibility.
+	// Also adjusts the available space of nearby tiles to account for this tiles' impassibility.
 	UFUNCTION(BlueprintCallable)
-	void PermitPathing(bool AllowPathing) 
-	{
-		TArray<ADungeonSingleTile*> tileList;
-		GetSurroundingTiles(tileList);
-		bPathingIgnore = !AllowPathing;
-		if (AllowPathing)
-		{
-			// If pathing allowed, ensure nearby tiles are updated to match the new space available.
-			for (auto tile : tileList)
-				if (tile)
-					tile->availableSpace = (tile->CheckSurroundingTiles()) ? 3 : 1;
-			// And update this tile accordingly.
-			availableSpace = CheckSurroundingTiles() ? 3 : 1;
-		}
-		else
-		{
-			// Pathing disallowed, nearby tiles can therefore only fit 1x1 occupants.
-			for (auto tile : tileList)
-				if (tile)
-					tile->availableSpace = 1;
-		}
-	}
+	void PermitPathing(bool AllowPathing);
 
-	bool bPathingIgnore = false;
-	// Pathfinding variables/functions
-	// Not actually used by this tile
-	ADungeonSingleTile* parent;
-	int availableSpace = -1;
-	float gCost;
-	float hCost;
-	float fCost() const { return gCost + hCost; }
+	// Clears everything tying this tile to a floor so it can be pooled & reused.
+	// Connections are dropped without touching the tile graph, which is reset as a whole.
+	void ResetTile();
+
+	// Registers this tile with the floors' tile graph. Called by the macro grid.
+	void SetTileGraph(FDungeonTileGraph* graph, int32 index) { Graph = graph; TileIndex = index; }
+
+	UFUNCTION(BlueprintPure)
+	bool IsPathingIgnored() const { return Graph ? Graph->IsPathingIgnored(TileIndex) : false; }
+
+	// The largest square occupant size that fits centred on this tile, 0 if unpathable & -1 if not yet assigned.
+	UFUNCTION(BlueprintPure)
+	int GetAvailableSpace() const { return Graph ? Graph->GetAvailableSpace(TileIndex) : -1; }
+
+	// Compact index of this tile across the whole floor, assigned by the macro grid.
+	// Pathfinding state is stored per query against this index rather than on the tile.
+	int32 TileIndex = INDEX_NONE;
 
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
+
+	// The floors' tile graph this tile belongs to, nullptr until added to a room.
+	FDungeonTileGraph* Graph = nullptr;
 };
\ No newline at end of file
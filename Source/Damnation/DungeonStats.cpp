@@ -0,0 +1,113 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DungeonStats.h"
+
+DEFINE_STAT(STAT_DungeonTurn);
+DEFINE_STAT(STAT_DungeonEnemyMovement);
+DEFINE_STAT(STAT_DungeonEnemyMoveAction);
+DEFINE_STAT(STAT_DungeonCleanupDeadEnemies);
+DEFINE_STAT(STAT_DungeonProjectileActions);
+DEFINE_STAT(STAT_DungeonPlayerAction);
+DEFINE_STAT(STAT_DungeonTormentorMovement);
+DEFINE_STAT(STAT_DungeonPathfinding);
+DEFINE_STAT(STAT_DungeonFlowField);
+DEFINE_STAT(STAT_DungeonInterpolation);
+DEFINE_STAT(STAT_DungeonInterpolatingOccupants);
+
+DEFINE_STAT(STAT_DungeonEnemiesMoved);
+DEFINE_STAT(STAT_DungeonPathsRequested);
+DEFINE_STAT(STAT_DungeonNodesExpanded);
+DEFINE_STAT(STAT_DungeonActorsSpawned);
+
+namespace
+{
+	// Upper bound of each histogram bucket in ms, the last bucket takes everything slower
+	constexpr int32 BucketLimitCount = 8;
+	const float BucketLimitsMs[BucketLimitCount] = { 0.25f, 0.5f, 1.0f, 2.0f, 4.0f, 8.0f, 16.0f, 33.3f };
+	constexpr int32 BucketCount = BucketLimitCount + 1;
+	// Width of the longest bar
+	const int32 BarLength = 40;
+}
+
+void FDungeonTurnProfiler::BeginTurn(uint32 pathRequests, uint64 nodesExpanded)
+{
+	Current = FTurn();
+	StartPathRequests = pathRequests;
+	StartNodesExpanded = nodesExpanded;
+	StartCycles = FPlatformTime::Cycles64();
+	bInTurn = true;
+}
+
+void FDungeonTurnProfiler::EndTurn(uint32 pathRequests, uint64 nodesExpanded)
+{
+	if (!bInTurn)
+		return;
+	bInTurn = false;
+	Current.Ms = FPlatformTime::ToMilliseconds64(FPlatformTime::Cycles64() - StartCycles);
+	Current.PathsRequested = pathRequests - StartPathRequests;
+	Current.NodesExpanded = (uint32)(nodesExpanded - StartNodesExpanded);
+
+	SET_DWORD_STAT(STAT_DungeonEnemiesMoved, Current.EnemiesMoved);
+	SET_DWORD_STAT(STAT_DungeonPathsRequested, Current.PathsRequested);
+	SET_DWORD_STAT(STAT_DungeonNodesExpanded, Current.NodesExpanded);
+	SET_DWORD_STAT(STAT_DungeonActorsSpawned, Current.ActorsSpawned);
+
+	if (Turns.Num() < TurnCapacity)
+		Turns.Add(Current);
+	else
+		Turns[NextTurn] = Current;
+	NextTurn = (NextTurn + 1) % TurnCapacity;
+}
+
+void FDungeonTurnProfiler::LogHistogram() const
+{
+	if (Turns.Num() == 0)
+	{
+		UE_LOG(LogTemp, Display, TEXT("Turn profiler: no turns recorded"));
+		return;
+	}
+
+	TArray<float> times;
+	times.Reserve(Turns.Num());
+	int32 buckets[BucketCount] = {};
+	double totalMs = 0.0;
+	uint64 enemiesMoved = 0, pathsRequested = 0, nodesExpanded = 0, actorsSpawned = 0;
+	for (const FTurn& turn : Turns)
+	{
+		times.Add(turn.Ms);
+		totalMs += turn.Ms;
+		enemiesMoved += turn.EnemiesMoved;
+		pathsRequested += turn.PathsRequested;
+		nodesExpanded += turn.NodesExpanded;
+		actorsSpawned += turn.ActorsSpawned;
+
+		int32 bucket = 0;
+		while (bucket < BucketCount - 1 && turn.Ms > BucketLimitsMs[bucket])
+			++bucket;
+		++buckets[bucket];
+	}
+	times.Sort();
+
+	const int32 count = Turns.Num();
+	UE_LOG(LogTemp, Display, TEXT("Turn profiler: last %d turns, avg %.3fms, p50 %.3fms, p99 %.3fms, max %.3fms"), count, totalMs / count,
+		times[(count - 1) / 2], times[FMath::Min(count - 1, (count * 99) / 100)], times.Last());
+	UE_LOG(LogTemp, Display, TEXT("Turn profiler: per turn avg %.1f enemies moved, %.1f paths requested, %.1f nodes expanded, %.1f actors spawned"),
+		(double)enemiesMoved / count, (double)pathsRequested / count, (double)nodesExpanded / count, (double)actorsSpawned / count);
+
+	int32 largest = 1;
+	for (int32 bucket : buckets)
+		largest = FMath::Max(largest, bucket);
+	for (int32 i = 0; i < BucketCount; ++i)
+	{
+		FString label = i < BucketCount - 1 ? FString::Printf(TEXT("<= %6.2fms"), BucketLimitsMs[i]) : FString::Printf(TEXT(" > %6.2fms"), BucketLimitsMs[i - 1]);
+		FString bar = FString::ChrN(FMath::DivideAndRoundUp(buckets[i] * BarLength, largest), TEXT('#'));
+		UE_LOG(LogTemp, Display, TEXT("  %s %4d %s"), *label, buckets[i], *bar);
+	}
+}
+
+void FDungeonTurnProfiler::Reset()
+{
+	Turns.Reset();
+	NextTurn = 0;
+	bInTurn = false;
+}
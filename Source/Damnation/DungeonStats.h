@@ -0,0 +1,99 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "Runtime/Launch/Resources/Version.h"
+// Unreal Insights' CPU trace arrived in 4.24
+#define DUNGEON_WITH_CPU_TRACE (ENGINE_MAJOR_VERSION > 4 || ENGINE_MINOR_VERSION >= 24)
+#if DUNGEON_WITH_CPU_TRACE
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#endif
+
+// "stat Damnation" in the console shows these
+DECLARE_STATS_GROUP(TEXT("Damnation"), STATGROUP_Damnation, STATCAT_Advanced);
+
+// Turn phases, see ADamnationGameModeBase::DoEnemyMovement
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Turn"), STAT_DungeonTurn, STATGROUP_Damnation, DAMNATION_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Enemy Movement"), STAT_DungeonEnemyMovement, STATGROUP_Damnation, DAMNATION_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Enemy ReceiveMoveAction"), STAT_DungeonEnemyMoveAction, STATGROUP_Damnation, DAMNATION_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Cleanup Dead Enemies"), STAT_DungeonCleanupDeadEnemies, STATGROUP_Damnation, DAMNATION_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Projectile Actions"), STAT_DungeonProjectileActions, STATGROUP_Damnation, DAMNATION_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Player Action"), STAT_DungeonPlayerAction, STATGROUP_Damnation, DAMNATION_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Tormentor Movement"), STAT_DungeonTormentorMovement, STATGROUP_Damnation, DAMNATION_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Pathfinding"), STAT_DungeonPathfinding, STATGROUP_Damnation, DAMNATION_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Flow Field"), STAT_DungeonFlowField, STATGROUP_Damnation, DAMNATION_API);
+
+// Per frame, outside of turns
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Occupant Interpolation"), STAT_DungeonInterpolation, STATGROUP_Damnation, DAMNATION_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Interpolating Occupants"), STAT_DungeonInterpolatingOccupants, STATGROUP_Damnation, DAMNATION_API);
+
+// Counts for the last turn
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Enemies Moved"), STAT_DungeonEnemiesMoved, STATGROUP_Damnation, DAMNATION_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Paths Requested"), STAT_DungeonPathsRequested, STATGROUP_Damnation, DAMNATION_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Nodes Expanded"), STAT_DungeonNodesExpanded, STATGROUP_Damnation, DAMNATION_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Actors Spawned"), STAT_DungeonActorsSpawned, STATGROUP_Damnation, DAMNATION_API);
+
+// Cycle counter for stat Damnation, plus a matching CPU scope for Unreal Insights where the engine has it.
+// Declares scoped locals & may expand to two statements, so only use it as a statement of its own in a braced block,
+// never as the lone body of an if or loop.
+#if DUNGEON_WITH_CPU_TRACE
+#define DUNGEON_SCOPE_CYCLE_COUNTER(Stat) \
+	SCOPE_CYCLE_COUNTER(Stat); \
+	TRACE_CPUPROFILER_EVENT_SCOPE(Stat)
+#else
+#define DUNGEON_SCOPE_CYCLE_COUNTER(Stat) \
+	SCOPE_CYCLE_COUNTER(Stat)
+#endif
+
+/*
+* Rolling record of the most recent turns' latency & counts, for finding out why a player step felt slow.
+* The phases within a turn are timed by the cycle stats above; this keeps the whole turns so their spread can be dumped.
+* Only used on the game thread.
+*/
+class DAMNATION_API FDungeonTurnProfiler
+{
+public:
+	// Number of turns kept
+	static const int32 TurnCapacity = 256;
+
+	// Starts timing a turn. The path counts are the macro grids' running totals, the turns' share is taken at EndTurn.
+	void BeginTurn(uint32 pathRequests, uint64 nodesExpanded);
+	// Records the turn & sets the stat counters to its counts.
+	void EndTurn(uint32 pathRequests, uint64 nodesExpanded);
+
+	bool IsInTurn() const { return bInTurn; }
+
+	// Counts, only kept while in a turn
+	void AddEnemyMoved() { if (bInTurn) ++Current.EnemiesMoved; }
+	void AddActorSpawned() { if (bInTurn) ++Current.ActorsSpawned; }
+
+	int32 Num() const { return Turns.Num(); }
+
+	// Logs a latency histogram of the kept turns, with percentiles & average counts.
+	void LogHistogram() const;
+
+	// Forgets every kept turn.
+	void Reset();
+
+private:
+	struct FTurn
+	{
+		float Ms = 0.0f;
+		uint32 EnemiesMoved = 0;
+		uint32 PathsRequested = 0;
+		uint32 NodesExpanded = 0;
+		uint32 ActorsSpawned = 0;
+	};
+
+	// Oldest turn is overwritten once full
+	TArray<FTurn> Turns;
+	int32 NextTurn = 0;
+
+	FTurn Current;
+	uint64 StartCycles = 0;
+	uint32 StartPathRequests = 0;
+	uint64 StartNodesExpanded = 0;
+	bool bInTurn = false;
+};
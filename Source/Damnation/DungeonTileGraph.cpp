@@ -0,0 +1,348 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DungeonTileGraph.h"
+#include "DungeonSingleTile.h"
+#include "DungeonRoomTileBase.h"
+
+int32 FDungeonTileGraph::AddTile(ADungeonSingleTile* tile, const FVector& location, int32 room, int32 localIndex)
+{
+	int32 index = Locations.Add(location);
+	Tiles.Add(tile);
+	for (int32 i = 0; i < CardinalCount; ++i)
+	{
+		Neighbours.Add(INDEX_NONE);
+		AxisNeighbours.Add(INDEX_NONE);
+	}
+	ConnectionMasks.Add(0);
+	AvailableSpace.Add(-1);
+	PathingIgnore.Add(false);
+	Occupants.Add(0);
+	Rooms.Add(room);
+	LocalIndices.Add((uint8)FMath::Max(localIndex, 0));
+	RoomSlots.Add(INDEX_NONE);
+	ClearanceQueued.Add(false);
+	if (room >= RoomTopologyVersions.Num())
+		RoomTopologyVersions.SetNumZeroed(room + 1);
+	if (room != INDEX_NONE)
+	{
+		if (room >= RoomTiles.Num())
+			RoomTiles.SetNum(room + 1);
+		// Unassigned space is the last bucket, so the tile just goes on the end
+		FRoomTiles& roomTiles = RoomTiles[room];
+		RoomSlots[index] = roomTiles.Tiles.Add(index);
+		++roomTiles.Ends[SpaceBucketCount - 1];
+	}
+	MarkTopologyChanged(index);
+	MarkClearanceDirty(index);
+	return index;
+}
+
+void FDungeonTileGraph::Reset()
+{
+	Tiles.Reset();
+	Locations.Reset();
+	Neighbours.Reset();
+	AxisNeighbours.Reset();
+	ConnectionMasks.Reset();
+	AvailableSpace.Reset();
+	PathingIgnore.Empty();
+	Occupants.Reset();
+	Rooms.Reset();
+	LocalIndices.Reset();
+	RoomSlots.Reset();
+	RoomTiles.Reset();
+	ClearanceDirty.Reset();
+	ClearanceQueued.Empty();
+	RoomTopologyVersions.Reset();
+	++TopologyVersion;
+	// Skip a position so anyone holding the old end sees their entries as discarded
+	JournalBase = GetJournalEnd() + 1;
+	Journal.Reset();
+}
+
+void FDungeonTileGraph::MarkTopologyChanged(int32 index)
+{
+	++TopologyVersion;
+	int32 room = Rooms[index];
+	if (room != INDEX_NONE)
+		++RoomTopologyVersions[room];
+
+	// Drop the older half once full so trimming stays cheap
+	if (Journal.Num() >= JournalCapacity)
+	{
+		const int32 trim = JournalCapacity / 2;
+		Journal.RemoveAt(0, trim, false);
+		JournalBase += trim;
+	}
+	Journal.Add(index);
+}
+
+bool FDungeonTileGraph::GetChangesSince(uint32 position, TArray<int32>& outTiles) const
+{
+	if (position < JournalBase || position > GetJournalEnd())
+		return false;
+	for (int32 i = position - JournalBase; i < Journal.Num(); ++i)
+		outTiles.Add(Journal[i]);
+	return true;
+}
+
+float FDungeonTileGraph::EstimateSteps(int32 a, int32 b) const
+{
+	// Tiles sit on a grid & links only join neighbours, so a 4-way mover needs at least the steps along X plus the steps along Y
+	FVector offset = Locations[b] - Locations[a];
+	return (FMath::Abs(offset.X) + FMath::Abs(offset.Y)) / ADungeonRoomTileBase::TileSeparation;
+}
+
+void FDungeonTileGraph::SetConnection(int32 a, int32 direction, int32 b)
+{
+	int32& neighbour = Neighbours[a * CardinalCount + direction];
+	int32 old = neighbour;
+	neighbour = b;
+	if (b != INDEX_NONE)
+		ConnectionMasks[a] |= (1 << direction);
+	else
+		ConnectionMasks[a] &= ~(1 << direction);
+	UpdateAxisNeighbours(a);
+	MarkTopologyChanged(a);
+
+	// Diagonals are found through cardinal links, so a link changing can change the surroundings of a, both ends & a's neighbours
+	MarkClearanceDirty(a);
+	if (old != INDEX_NONE)
+		MarkClearanceDirty(old);
+	if (b != INDEX_NONE)
+		MarkClearanceDirty(b);
+	for (int32 dir = 0; dir < CardinalCount; ++dir)
+	{
+		int32 adjacent = GetNeighbour(a, dir);
+		if (adjacent != INDEX_NONE)
+			MarkClearanceDirty(adjacent);
+	}
+}
+
+void FDungeonTileGraph::UpdateAxisNeighbours(int32 index)
+{
+	// Rebuilt from every slot, as two slots can hold the same tile
+	int32* axisNeighbours = &AxisNeighbours[index * CardinalCount];
+	for (int32 axis = 0; axis < CardinalCount; ++axis)
+		axisNeighbours[axis] = INDEX_NONE;
+	for (int32 dir = 0; dir < CardinalCount; ++dir)
+	{
+		int32 connection = GetNeighbour(index, dir);
+		if (connection == INDEX_NONE)
+			continue;
+		FVector offset = Locations[connection] - Locations[index];
+		int32 axis = FMath::Abs(offset.X) >= FMath::Abs(offset.Y) ? (offset.X > 0.0f ? 0 : 2) : (offset.Y > 0.0f ? 1 : 3);
+		axisNeighbours[axis] = connection;
+	}
+}
+
+void FDungeonTileGraph::SetPathingIgnored(int32 index, bool ignore)
+{
+	if (PathingIgnore[index] == ignore)
+		return;
+	PathingIgnore[index] = ignore;
+	MarkTopologyChanged(index);
+	MarkClearanceDirty(index);
+}
+
+void FDungeonTileGraph::MarkClearanceDirty(int32 index)
+{
+	if (ClearanceQueued[index])
+		return;
+	ClearanceQueued[index] = true;
+	ClearanceDirty.Add(index);
+}
+
+int32 FDungeonTileGraph::ComputeClearanceRadius(int32 index) const
+{
+	if (PathingIgnore[index])
+		return -1;
+
+	// A footprint of radius r fits if every surrounding tile exists & fits radius r - 1
+	int32 surrounding[8];
+	GetSurroundingTiles(index, surrounding);
+	int32 radius = MaxClearanceRadius;
+	for (int32 tile : surrounding)
+	{
+		if (tile == INDEX_NONE)
+			return 0;
+		// Unpathable tiles have 0 space, & uncomputed tiles -1, both of which block any footprint over them
+		int32 space = AvailableSpace[tile];
+		int32 tileRadius = space > 0 ? (space - 1) / 2 : -1;
+		radius = FMath::Min(radius, tileRadius + 1);
+	}
+	return radius;
+}
+
+int32 FDungeonTileGraph::UpdateClearance(int32 maxTiles)
+{
+	int32 changed = 0;
+	// Work through the dirty tiles, requeueing the surroundings of any tile whose space changed until nothing changes.
+	// Radii are capped, so a change can only spread MaxClearanceRadius tiles.
+	for (int32 checked = 0; ClearanceDirty.Num() > 0 && checked < maxTiles; ++checked)
+	{
+		int32 index = ClearanceDirty.Pop(false);
+		ClearanceQueued[index] = false;
+
+		int32 radius = ComputeClearanceRadius(index);
+		int8 space = radius < 0 ? 0 : (int8)(radius * 2 + 1);
+		if (AvailableSpace[index] == space)
+			continue;
+		SetAvailableSpace(index, space);
+		MarkTopologyChanged(index);
+		++changed;
+
+		int32 surrounding[8];
+		GetSurroundingTiles(index, surrounding);
+		for (int32 tile : surrounding)
+			if (tile != INDEX_NONE)
+				MarkClearanceDirty(tile);
+	}
+	return changed;
+}
+
+int32 FDungeonTileGraph::GetSpaceBucket(int32 space)
+{
+	if (space < 0)
+		return 0;
+	if (space == 0)
+		return 1;
+	// Spaces are always odd, so even sizes need the next one up
+	int32 oddSpace = space % 2 == 0 ? space + 1 : space;
+	return (oddSpace + 1) / 2 + 1;
+}
+
+void FDungeonTileGraph::SetAvailableSpace(int32 index, int8 space)
+{
+	int32 key = SpaceBucketCount - 1 - GetSpaceBucket(AvailableSpace[index]);
+	AvailableSpace[index] = space;
+	int32 room = Rooms[index];
+	if (room == INDEX_NONE)
+		return;
+
+	// Step the tile across one bucket boundary at a time, swapping it with the tile on the edge of each bucket & moving the edge past it
+	int32 newKey = SpaceBucketCount - 1 - GetSpaceBucket(space);
+	FRoomTiles& roomTiles = RoomTiles[room];
+	for (; key > newKey; --key)
+	{
+		SwapRoomSlots(room, RoomSlots[index], roomTiles.Ends[key - 1]);
+		++roomTiles.Ends[key - 1];
+	}
+	for (; key < newKey; ++key)
+	{
+		SwapRoomSlots(room, RoomSlots[index], roomTiles.Ends[key] - 1);
+		--roomTiles.Ends[key];
+	}
+}
+
+void FDungeonTileGraph::SwapRoomSlots(int32 room, int32 slotA, int32 slotB)
+{
+	if (slotA == slotB)
+		return;
+	TArray<int32>& tiles = RoomTiles[room].Tiles;
+	tiles.Swap(slotA, slotB);
+	RoomSlots[tiles[slotA]] = slotA;
+	RoomSlots[tiles[slotB]] = slotB;
+}
+
+int32 FDungeonTileGraph::GetRandomRoomTile(int32 room, int32 minSpace, FRandomStream& stream) const
+{
+	int32 bucket = GetSpaceBucket(minSpace);
+	if (!RoomTiles.IsValidIndex(room) || bucket >= SpaceBucketCount)
+		return INDEX_NONE;
+	const FRoomTiles& roomTiles = RoomTiles[room];
+	int32 count = roomTiles.Ends[SpaceBucketCount - 1 - bucket];
+	return count > 0 ? roomTiles.Tiles[stream.RandRange(0, count - 1)] : INDEX_NONE;
+}
+
+void FDungeonTileGraph::GetSurroundingTiles(int32 index, int32 (&outTiles)[8]) const
+{
+	// Trackers for tiles outside of this tiles' direct influence
+	int32 tl = INDEX_NONE;
+	int32 tr = INDEX_NONE;
+	int32 bl = INDEX_NONE;
+	int32 br = INDEX_NONE;
+
+	for (int32 i = 0; i < CardinalCount; ++i)
+	{
+		int32 current = GetNeighbour(index, i);
+		outTiles[i] = current;
+
+		if (current == INDEX_NONE)
+			continue;
+
+		if (i % 2 == 0)
+		{
+			int32 left = GetNeighbour(current, 3);
+			int32 right = GetNeighbour(current, 1);
+			int32& leftCorner = (i == 0) ? tl : bl;
+			int32& rightCorner = (i == 0) ? tr : br;
+			leftCorner = leftCorner != INDEX_NONE ? leftCorner : left;
+			rightCorner = rightCorner != INDEX_NONE ? rightCorner : right;
+		}
+		else
+		{
+			int32 up = GetNeighbour(current, 0);
+			int32 down = GetNeighbour(current, 2);
+			int32& upCorner = (i == 1) ? tr : tl;
+			int32& downCorner = (i == 1) ? br : bl;
+			upCorner = upCorner != INDEX_NONE ? upCorner : up;
+			downCorner = downCorner != INDEX_NONE ? downCorner : down;
+		}
+	}
+	outTiles[4] = tl;
+	outTiles[5] = tr;
+	outTiles[6] = br;
+	outTiles[7] = bl;
+}
+
+bool FDungeonTileGraph::CheckSurroundingTiles(int32 index) const
+{
+	for (int32 i = 0; i < CardinalCount; ++i)
+	{
+		int32 cardinal = GetNeighbour(index, i);
+		if (cardinal == INDEX_NONE || PathingIgnore[cardinal])
+			return false;
+
+		if (i % 2 == 0)
+		{
+			int32 east = GetNeighbour(cardinal, 1);
+			int32 west = GetNeighbour(cardinal, 3);
+			if (east == INDEX_NONE || west == INDEX_NONE || PathingIgnore[east] || PathingIgnore[west])
+				return false;
+		}
+	}
+	return true;
+}
+
+uint32 FDungeonTileGraph::MakeOccupantHandle(const AActor* actor)
+{
+	return actor ? actor->GetUniqueID() : 0;
+}
+
+ADungeonSingleTile* FDungeonTileGraph::GetTile(int32 index) const
+{
+	if (!Tiles.IsValidIndex(index))
+		return nullptr;
+	if (!Tiles[index] && ProxyFactory)
+		return ProxyFactory(index);
+	return Tiles[index];
+}
+
+void FDungeonTileGraph::ToTiles(const TArray<int32>& indices, TArray<ADungeonSingleTile*>& outTiles) const
+{
+	outTiles.Reset(indices.Num());
+	for (int32 index : indices)
+		outTiles.Add(GetTile(index));
+}
+
+SIZE_T FDungeonTileGraph::GetAllocatedSize() const
+{
+	SIZE_T size = Tiles.GetAllocatedSize() + Locations.GetAllocatedSize() + Neighbours.GetAllocatedSize() + AxisNeighbours.GetAllocatedSize()
+		+ ConnectionMasks.GetAllocatedSize() + AvailableSpace.GetAllocatedSize() + PathingIgnore.GetAllocatedSize() + Occupants.GetAllocatedSize()
+		+ Rooms.GetAllocatedSize() + LocalIndices.GetAllocatedSize() + ClearanceDirty.GetAllocatedSize() + ClearanceQueued.GetAllocatedSize()
+		+ Journal.GetAllocatedSize() + RoomTopologyVersions.GetAllocatedSize() + RoomSlots.GetAllocatedSize() + RoomTiles.GetAllocatedSize();
+	for (const FRoomTiles& roomTiles : RoomTiles)
+		size += roomTiles.Tiles.GetAllocatedSize();
+	return size;
+}
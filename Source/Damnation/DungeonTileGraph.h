@@ -0,0 +1,212 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Math/RandomStream.h"
+
+class AActor;
+class ADungeonSingleTile;
+
+/*
+* Flat structure-of-arrays store of every tile on the floor.
+* Built as rooms add & connect tiles, and is the authoritative store for connections, available space,
+* pathing permission & occupancy. Pathfinding & tile shape queries run entirely on this.
+* Tiles are data only; an ADungeonSingleTile proxy actor is spawned for a tile the first time one is asked for.
+* Tiles are referred to by their compact index (ADungeonSingleTile::TileIndex).
+*/
+struct DAMNATION_API FDungeonTileGraph
+{
+	static const int32 CardinalCount = 4;
+
+	// Spawns the proxy actor for a tile index that has none yet.
+	typedef TFunction<ADungeonSingleTile*(int32)> FProxyFactory;
+
+	// Adds a tile with no connections & returns its index. tile is its proxy actor, nullptr to spawn one when first needed.
+	// room is the rooms' flat index on the macro grid, localIndex the tiles' flat index within that room.
+	int32 AddTile(ADungeonSingleTile* tile, const FVector& location, int32 room = INDEX_NONE, int32 localIndex = INDEX_NONE);
+
+	// Removes every tile from the graph. The proxy factory is kept.
+	void Reset();
+
+	int32 Num() const { return Locations.Num(); }
+	bool IsValidTile(int32 index) const { return Locations.IsValidIndex(index); }
+
+	// Connection functions
+	// direction is the ECardinal value (0 == North, 1 == East...)
+
+	// Sets a single, one-way connection from a to b. b may be INDEX_NONE to clear the connection.
+	void SetConnection(int32 a, int32 direction, int32 b);
+
+	int32 GetNeighbour(int32 index, int32 direction) const
+	{
+		return index == INDEX_NONE ? INDEX_NONE : Neighbours[index * CardinalCount + direction];
+	}
+
+	// 4-bit mask of valid connections, bit n set for direction n.
+	uint8 GetConnectionMask(int32 index) const { return ConnectionMasks[index]; }
+
+	// Connections by the way they lead rather than the slot they're stored in, which depends on the order tiles were linked in.
+	// axis is 0 == +X, 1 == +Y, 2 == -X, 3 == -Y. Returns INDEX_NONE if no connection leads that way.
+	int32 GetNeighbourOnAxis(int32 index, int32 axis) const { return AxisNeighbours[index * CardinalCount + axis]; }
+
+	/*
+	* Fills outTiles with the indices of all tiles adjacent to index, cardinally & diagonally, INDEX_NONE if no tile exists.
+	* Array is arranged in the same order as ADungeonSingleTile::GetSurroundingTiles:
+	*
+	* [4][0][5]
+	* [3][X][1]
+	* [7][2][6]
+	*/
+	void GetSurroundingTiles(int32 index, int32 (&outTiles)[8]) const;
+
+	// Checks every tile adjacent to index exists & is pathable, cardinally & diagonally.
+	bool CheckSurroundingTiles(int32 index) const;
+
+	// Tile state
+
+	bool IsPathingIgnored(int32 index) const { return PathingIgnore[index]; }
+	void SetPathingIgnored(int32 index, bool ignore);
+
+	// Clearance
+	// A tiles' available space is the side length of the largest square footprint centred on it that only covers pathable tiles,
+	// 0 if the tile itself can't be pathed on. Adding, connecting or toggling tiles marks the tiles around them dirty;
+	// UpdateClearance recomputes only those & spreads outwards while values keep changing.
+	static const int32 MaxClearanceRadius = 7;
+
+	// The largest footprint that fits centred on the tile, -1 if not yet computed.
+	int32 GetAvailableSpace(int32 index) const { return AvailableSpace[index]; }
+
+	// Recomputes the available space of every dirty tile. Returns the number of tiles whose space changed.
+	// Stops after checking maxTiles tiles; call again while IsClearanceDirty to finish.
+	int32 UpdateClearance(int32 maxTiles = MAX_int32);
+
+	bool IsClearanceDirty() const { return ClearanceDirty.Num() > 0; }
+
+	// Picks a random tile in room whose available space is at least minSpace with a single draw from stream.
+	// Returns INDEX_NONE if the room has no such tile.
+	int32 GetRandomRoomTile(int32 room, int32 minSpace, FRandomStream& stream) const;
+
+	// The room the tile belongs to (flat macro grid index), INDEX_NONE if not added through a room.
+	int32 GetRoom(int32 index) const { return Rooms[index]; }
+	// The tiles' flat index within its room.
+	int32 GetLocalIndex(int32 index) const { return LocalIndices[index]; }
+	// One past the highest room index any tile was added with.
+	int32 GetRoomCount() const { return RoomTiles.Num(); }
+	// Every tile added through room, in no particular order.
+	const TArray<int32>& GetRoomTiles(int32 room) const { return RoomTiles[room].Tiles; }
+
+	// Versioning
+	// Bumped whenever a connection, pathing permission or available space changes, so cached results can be invalidated.
+	uint32 GetTopologyVersion() const { return TopologyVersion; }
+	// Per-room version, only bumped by changes to tiles within that room.
+	uint32 GetRoomTopologyVersion(int32 room) const { return RoomTopologyVersions.IsValidIndex(room) ? RoomTopologyVersions[room] : 0; }
+
+	// Change journal
+	// Every topology change appends the tile it happened on, so incremental searches can repair just those tiles.
+	// Only the most recent JournalCapacity entries are kept.
+	static const int32 JournalCapacity = 4096;
+
+	// Position after the latest journal entry, store this & pass it to GetChangesSince later.
+	uint32 GetJournalEnd() const { return JournalBase + Journal.Num(); }
+
+	// Appends every tile changed since position to outTiles.
+	// Returns false if those entries have been discarded or the graph was reset, the consumer must rebuild from scratch.
+	bool GetChangesSince(uint32 position, TArray<int32>& outTiles) const;
+
+	// Occupancy is stored as a handle (the actors' unique ID), 0 when unoccupied.
+	static uint32 MakeOccupantHandle(const AActor* actor);
+	uint32 GetOccupant(int32 index) const { return Occupants[index]; }
+	void SetOccupant(int32 index, uint32 handle)
+	{
+		if (Occupants[index] != handle)
+		{
+			Occupants[index] = handle;
+			++OccupancyVersion;
+		}
+	}
+
+	// Bumped whenever any tiles' occupant changes. Kept apart from the topology version as it changes every turn.
+	uint32 GetOccupancyVersion() const { return OccupancyVersion; }
+
+	const FVector& GetLocation(int32 index) const { return Locations[index]; }
+
+	// Steps from a to b ignoring walls, the heuristic shared by every search over the graph.
+	float EstimateSteps(int32 a, int32 b) const;
+
+	// Proxies
+
+	void SetProxyFactory(FProxyFactory factory) { ProxyFactory = MoveTemp(factory); }
+
+	// Gets the tile actor for the index, spawning its proxy through the factory if it has none yet. Only safe on the game thread.
+	ADungeonSingleTile* GetTile(int32 index) const;
+
+	// Gets the tile actor for the index only if its proxy has already been spawned.
+	ADungeonSingleTile* FindTile(int32 index) const { return Tiles.IsValidIndex(index) ? Tiles[index] : nullptr; }
+
+	// Stores the proxy spawned for a tile.
+	void SetTile(int32 index, ADungeonSingleTile* tile) { Tiles[index] = tile; }
+
+	// Converts a list of indices to their tile actors, spawning any missing proxies.
+	void ToTiles(const TArray<int32>& indices, TArray<ADungeonSingleTile*>& outTiles) const;
+
+	// Memory held by the graphs' arrays.
+	SIZE_T GetAllocatedSize() const;
+
+private:
+	void MarkTopologyChanged(int32 index);
+
+	// Rebuilds the tiles' axis neighbours from its connections.
+	void UpdateAxisNeighbours(int32 index);
+
+	void MarkClearanceDirty(int32 index);
+	// Radius of the largest footprint centred on index given its surrounding tiles' current values.
+	int32 ComputeClearanceRadius(int32 index) const;
+
+	// Space buckets
+	// Each rooms' tiles are kept in one list ordered by available space, largest first, so the tiles fitting any size are a prefix of it.
+	// Bucket 0 holds unassigned tiles, 1 unpathable tiles & the rest each odd space from 1 up.
+	static const int32 SpaceBucketCount = MaxClearanceRadius + 3;
+	// The lowest bucket holding tiles with at least space.
+	static int32 GetSpaceBucket(int32 space);
+	void SetAvailableSpace(int32 index, int8 space);
+	void SwapRoomSlots(int32 room, int32 slotA, int32 slotB);
+
+	struct FRoomTiles
+	{
+		// Tile indices, largest space first
+		TArray<int32> Tiles;
+		// End of each bucket's run in Tiles, indexed by SpaceBucketCount - 1 - bucket
+		int32 Ends[SpaceBucketCount] = {};
+	};
+
+	// Proxy actors, nullptr until one is asked for. Released by their rooms.
+	TArray<ADungeonSingleTile*> Tiles;
+	FProxyFactory ProxyFactory;
+	TArray<FVector> Locations;
+	// CardinalCount entries per tile
+	TArray<int32> Neighbours;
+	// CardinalCount entries per tile, indexed by axis
+	TArray<int32> AxisNeighbours;
+	TArray<uint8> ConnectionMasks;
+	TArray<int8> AvailableSpace;
+	TBitArray<> PathingIgnore;
+	TArray<uint32> Occupants;
+	TArray<int32> Rooms;
+	TArray<uint8> LocalIndices;
+	// Each tiles' position in its rooms' FRoomTiles list
+	TArray<int32> RoomSlots;
+	TArray<FRoomTiles> RoomTiles;
+
+	uint32 TopologyVersion = 0;
+	TArray<uint32> RoomTopologyVersions;
+	uint32 OccupancyVersion = 0;
+
+	// Tiles waiting on UpdateClearance
+	TArray<int32> ClearanceDirty;
+	TBitArray<> ClearanceQueued;
+
+	TArray<int32> Journal;
+	// Journal position of Journal[0]
+	uint32 JournalBase = 0;
+};
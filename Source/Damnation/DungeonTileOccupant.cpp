@@ -18,14 +18,44 @@ ADungeonTileOccupant::ADungeonTileOccupant()
 	LaggedRoot->SetupAttachment(RootComponent);
 }
 
+void ADungeonTileOccupant::BeginPlay()
+{
+	Super::BeginPlay();
+	// Asleep until the first action
+	if (Gamemode && !bTickWhileIdle)
+		SetActorTickEnabled(false);
+}
+
 void ADungeonTileOccupant::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
+	// Without a game mode there's no interpolation manager, so interpolate here
+	if (!Gamemode)
+		AdvanceInterpolation(DeltaTime);
+}
+
+void ADungeonTileOccupant::WakeInterpolation()
+{
+	if (!Gamemode)
+		return;
+	SetActorTickEnabled(true);
+	Gamemode->Interpolation.Add(this);
+}
+
+bool ADungeonTileOccupant::AdvanceInterpolation(float DeltaTime)
+{
 	TimeUntilActionPermitted = FMath::Max(TimeUntilActionPermitted - DeltaTime, 0.0f);
 	ActionTimeScalar = TimeUntilActionPermitted / ActionTime;
 
 	FTransform lerpPos = UKismetMathLibrary::TLerp(GetActorTransform(), OldTransform, ActionTimeScalar);
 	LaggedRoot->SetWorldTransform(lerpPos);
+	return ActionTimeScalar > 0.0f;
+}
+
+void ADungeonTileOccupant::SleepInterpolation()
+{
+	if (!bTickWhileIdle)
+		SetActorTickEnabled(false);
 }
 
 
@@ -53,9 +83,22 @@ void ADungeonTileOccupant::SetTile(ADungeonSingleTile* tile)
 {
 	SetActorLocation(tile->GetActorLocation(), false, nullptr, ETeleportType::TeleportPhysics);
 	LaggedRoot->SetWorldTransform(OldTransform);
-	if (CurrentTile) CurrentTile->OccupyingActor = nullptr;
-	tile->OccupyingActor = this;
+	if (CurrentTile) CurrentTile->SetOccupyingActor(nullptr);
+	tile->SetOccupyingActor(this);
 	CurrentTile = tile;
 	ReceiveOnMove(OldTransform, GetActorTransform());
 	tile->TileEvent.Broadcast(this, tile);
+	WakeInterpolation();
+}
+
+bool ADungeonTileOccupant::CanSeePlayer()
+{
+	ADungeonCrawlerPlayer* player = Gamemode ? Gamemode->GetPlayer() : nullptr;
+	if (!player)
+		return false;
+	if (Gamemode->DungeonMap && CurrentTile && player->CurrentTile && CurrentTile->TileIndex != INDEX_NONE && player->CurrentTile->TileIndex != INDEX_NONE)
+		return CurrentTile != player->CurrentTile && Gamemode->DungeonMap->HasLineOfSight(CurrentTile, player->CurrentTile);
+
+	FHitResult sightResult = SightCheck();
+	return sightResult.Actor.Get() == player && sightResult.Distance;
 }
@@ -37,9 +37,15 @@ public:
 	virtual void SetTile(ADungeonSingleTile* tile);
 
 	// Does a raycast from this to the player, returns hit result that will hit any SightBlocker blocking collider
+	// Prefer CanSeePlayer, which doesn't need physics.
 	UFUNCTION(BlueprintCallable)
 	FHitResult SightCheck();
 
+	// Whether there's a clear line from this occupants' tile to the players', checked on the tile grid.
+	// Falls back to SightCheck when either isn't on a tile of the dungeon map.
+	UFUNCTION(BlueprintCallable)
+	bool CanSeePlayer();
+
 	// Called when a movement action is performed
 	// Positions refer to the player pre- and post- movement action, respectively
 	UFUNCTION(BlueprintImplementableEvent, meta = (DisplayName = "OnMove"))
@@ -49,9 +55,26 @@ public:
 	UPROPERTY(BlueprintReadWrite)
 	ADungeonSingleTile* CurrentTile;
 
+	// Starts moving the lagged root from OldTransform toward the actor & counting down TimeUntilActionPermitted, waking this up.
+	// Called automatically by SetTile & after each action; call after setting TimeUntilActionPermitted any other way.
+	UFUNCTION(BlueprintCallable)
+	void WakeInterpolation();
+
+	// Steps the countdown & lagged root by DeltaTime. Returns false once the lagged root has caught up.
+	// Called each frame by the game modes' interpolation manager while awake.
+	bool AdvanceInterpolation(float DeltaTime);
+
+	// Stops ticking until the next wake, unless bTickWhileIdle. Called by the interpolation manager once caught up.
+	void SleepInterpolation();
+
 protected:
 	// Called when the game starts or when spawned
-	virtual void BeginPlay() override { Super::BeginPlay(); }
+	virtual void BeginPlay() override;
+
+	// Whether the actor keeps ticking while standing still, for Blueprints whose Tick must always run.
+	// Otherwise the actor only ticks between an action & its lagged root catching up.
+	UPROPERTY(EditDefaultsOnly, Category = "Occupant Variables")
+	bool bTickWhileIdle = false;
 
 	UPROPERTY(BlueprintReadWrite)
 	USceneComponent* LaggedRoot;
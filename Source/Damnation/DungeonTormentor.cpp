@@ -19,6 +19,10 @@ void ADungeonTormentor::BeginPlay()
 {
 	Super::BeginPlay();
 	
+	if (Gamemode)
+		Random.Initialize(Gamemode->GetStreamSeed(EDungeonRandomStream::TORMENTOR));
+	else
+		Random.GenerateNewSeed();
 	Health = MaxHealth;
 	ActionTime = MoveDuration;
 }
@@ -41,21 +45,25 @@ void ADungeonTormentor::PerformMovement()
 	// Will be properly set later if necessary
 	OldTransform = GetActorTransform();
 
+	const FDungeonTileGraph& graph = Gamemode->DungeonMap->GetTileGraph();
+	const uint32 playerHandle = FDungeonTileGraph::MakeOccupantHandle(Gamemode->ActivePlayer);
+	const uint32 selfHandle = FDungeonTileGraph::MakeOccupantHandle(this);
+
 	// See if we can spot the player in our attack ranges
-	TArray<ADungeonSingleTile*> tileSet;
+	TArray<int32> tileSet;
 	bool playerInSlamRange = false;
-	bool slamValid = GetSlamAttackTiles(Facing, tileSet);
-	for (auto tile : tileSet)
-		if (tile && dynamic_cast<ADungeonCrawlerPlayer*>(tile->OccupyingActor))
+	bool slamValid = GetSlamAttackTileIndices(graph, (int)Facing, tileSet);
+	for (int32 tile : tileSet)
+		if (tile != INDEX_NONE && playerHandle != 0 && graph.GetOccupant(tile) == playerHandle)
 		{
 			playerInSlamRange = true;
 			break;
 		}
 
 	bool playerInSwipeRange = false;
-	bool swipeValid = GetSwipeAttackTiles(Facing, tileSet);
-	for (auto tile : tileSet)
-		if (tile && dynamic_cast<ADungeonCrawlerPlayer*>(tile->OccupyingActor))
+	bool swipeValid = GetSwipeAttackTileIndices(graph, (int)Facing, tileSet);
+	for (int32 tile : tileSet)
+		if (tile != INDEX_NONE && playerHandle != 0 && graph.GetOccupant(tile) == playerHandle)
 		{
 			playerInSwipeRange = true;
 			break;
@@ -69,7 +77,7 @@ void ADungeonTormentor::PerformMovement()
 			if (!swipeValid)
 				attackPrepared = ETormentorAttackType::SLAM;
 			else
-				attackPrepared = (ETormentorAttackType)FMath::RandRange(0, 1);
+				attackPrepared = (ETormentorAttackType)Random.RandRange(0, 1);
 		}
 		else if (playerInSlamRange) attackPrepared = ETormentorAttackType::SLAM;
 		else attackPrepared = ETormentorAttackType::SWIPE;
@@ -99,9 +107,8 @@ void ADungeonTormentor::PerformMovement()
 		ReceiveMoveAction();
 
 		// Can see player, repath if necessary
-		auto sightResult = SightCheck();
-		ADungeonCrawlerPlayer* playerSight = dynamic_cast<ADungeonCrawlerPlayer*>(sightResult.Actor.Get());
-		bCanSeePlayer = playerSight && sightResult.Distance ? true : false;
+		bCanSeePlayer = CanSeePlayer();
+		ADungeonCrawlerPlayer* playerSight = bCanSeePlayer ? Gamemode->GetPlayer() : nullptr;
 		ReceivePlayerSightCheck(bCanSeePlayer);
 
 		// This is the first time we've spotted the player, do relevant first-spot actions
@@ -127,6 +134,15 @@ void ADungeonTormentor::PerformMovement()
 				LastPlayerSeenTile = playerSight->CurrentTile;
 			}
 
+			// Refine the next room of a long route once the current one has been walked
+			if (DesiredPath.Num() == 0 && Route.HasSegments() && !Gamemode->DungeonMap->RefineRoute(Route, DesiredPath))
+			{
+				// The floor changed since the route was planned, plan it again
+				ADungeonSingleTile* routeTarget = graph.GetTile(Route.GetTarget());
+				Route.Reset();
+				SetTarget(routeTarget);
+			}
+
 			if (DesiredPath.Num() > 0)
 			{
 				OnTormentorMovementAction.Broadcast();
@@ -134,7 +150,7 @@ void ADungeonTormentor::PerformMovement()
 				// Check tiles forward of desired tile based on movement direction
 				// Get direction of movement
 				uint8 dir = 0;
-				while (CurrentTile->CardinalConnections[dir] != nextTile) ++dir;
+				while (CurrentTile->GetAdjacent((ECardinal)dir) != nextTile) ++dir;
 
 				// Check if our facing direction matches the next intended direction
 				if (dir != (uint8)Facing)
@@ -144,30 +160,33 @@ void ADungeonTormentor::PerformMovement()
 				}
 				else
 				{
-					AActor* occupant = nullptr;
+					uint32 occupant = 0;
 					// array of tiles that will be occupied on move if successful
-					TArray<ADungeonSingleTile*> occupyTiles;
-					GetTilesDirectional(dir, occupyTiles);
+					TArray<int32> occupyTiles;
+					GetTileIndicesDirectional(graph, dir, occupyTiles);
 
-					for (auto occupyTile : occupyTiles)
+					for (int32 occupyTile : occupyTiles)
 					{
-						if (occupyTile)
-							if (occupyTile->OccupyingActor && occupyTile->OccupyingActor != this)
+						if (occupyTile != INDEX_NONE)
+						{
+							uint32 tileOccupant = graph.GetOccupant(occupyTile);
+							if (tileOccupant != 0 && tileOccupant != selfHandle)
 							{
-								occupant = occupyTile->OccupyingActor;
+								occupant = tileOccupant;
 								break;
 							}
+						}
 					}
 
 					// LaggedRoot->SetRelativeRotation(FQuat(FRotator(0, (dir - 1) * 90.0f, 0)));
 
 					// Something is in the way, do a swipe attack to get it out of the way
-					if (occupant != nullptr)
+					if (occupant != 0)
 					{
 						if (!swipeValid)
 							attackPrepared = ETormentorAttackType::SLAM;
 						else
-							attackPrepared = (ETormentorAttackType)FMath::RandRange(0, 1);
+							attackPrepared = (ETormentorAttackType)Random.RandRange(0, 1);
 						bIsAttacking = true;
 						// To prevent delay between detecting blocking entity & preparing the attack, immediately activate next action.
 						ActionTime = 0.0f;
@@ -226,6 +245,7 @@ void ADungeonTormentor::PerformMovement()
 		}
 	}
 	TimeUntilActionPermitted = ActionTime;
+	WakeInterpolation();
 
 	ReceiveOnMove(OldTransform, GetActorTransform());
 }
@@ -236,7 +256,7 @@ void ADungeonTormentor::RotateToDirection(const ECardinal& dir)
 	uint8 diff = (((uint8)dir - (uint8)Facing) + 4) % 4;
 	// Clamp rotation to 90 degrees per action max.
 	if (diff == 2)
-		diff = FMath::RandBool() ? 1 : 3;
+		diff = Random.RandBool() ? 1 : 3;
 	ECardinal newDir = ECardinal(((uint8)Facing + diff) % 4);
 
 	// Relative direction we're about to make. from 1..3 to -1..1
@@ -273,93 +293,122 @@ bool ADungeonTormentor::AlterHealth(int val)
 				TArray<ADungeonSingleTile*> currentNearTiles;
 				CurrentTile->GetSurroundingTiles(currentNearTiles);
 				for (ADungeonSingleTile* nearTile : currentNearTiles)
-					if (nearTile) nearTile->OccupyingActor = nullptr;
-				CurrentTile->OccupyingActor = nullptr;
+					if (nearTile) nearTile->SetOccupyingActor(nullptr);
+				CurrentTile->SetOccupyingActor(nullptr);
 			}
 		}
 	}
 	return bIsVulnerable;
 }
 
-bool ADungeonTormentor::GetTilesDirectional(int direction, TArray<ADungeonSingleTile*>& tileList)
+const FDungeonTileGraph* ADungeonTormentor::GetTileGraph() const
+{
+	return (Gamemode && Gamemode->DungeonMap) ? &Gamemode->DungeonMap->GetTileGraph() : nullptr;
+}
+
+bool ADungeonTormentor::GetTileIndicesDirectional(const FDungeonTileGraph& graph, int direction, TArray<int32>& tileList) const
 {
 	direction = direction % 4;
-	tileList.Empty(3);
+	tileList.Reset(3);
 	// Middle tile in forward dir
 	// Jumps forward 1 to account for 3x3 size of tormentor
-	auto mid = CurrentTile->CardinalConnections[direction]->CardinalConnections[direction];
+	int32 mid = graph.GetNeighbour(graph.GetNeighbour(CurrentTile->TileIndex, direction), direction);
 	// x + 3 % 4 is effectively -1 for getting direction difference without out of range index error possibility
-	if (mid)
+	if (mid != INDEX_NONE)
 	{
-		tileList.Add(mid->CardinalConnections[(direction + 3) % 4]);
+		tileList.Add(graph.GetNeighbour(mid, (direction + 3) % 4));
 		tileList.Add(mid);
-		tileList.Add(mid->CardinalConnections[(direction + 1) % 4]);
+		tileList.Add(graph.GetNeighbour(mid, (direction + 1) % 4));
 	}
 
-	for (auto tile : tileList)
-		if (!tile)
-			return false;
-	return true;
+	return !tileList.Contains(INDEX_NONE);
 }
 
-bool ADungeonTormentor::GetSwipeAttackTiles(int direction, TArray<ADungeonSingleTile*>& tileList)
+bool ADungeonTormentor::GetSwipeAttackTileIndices(const FDungeonTileGraph& graph, int direction, TArray<int32>& tileList) const
 {
 	direction = direction % 4;
-	tileList.Empty(10);
+	tileList.Reset(10);
 	// Middle tile in forward dir
 	// Jumps forward 1 to account for 3x3 size of tormentor
-	auto mid = CurrentTile->CardinalConnections[direction]->CardinalConnections[direction];
+	int32 mid = graph.GetNeighbour(graph.GetNeighbour(CurrentTile->TileIndex, direction), direction);
 	// x + 3 % 4 is effectively -1 for getting direction difference without out of range index error possibility
-	if (mid)
+	if (mid != INDEX_NONE)
 	{
 		// Leftmost tiles
-		auto leftT = mid->CardinalConnections[(direction + 3) % 4];
-		if (leftT)
-			tileList.Add(leftT->CardinalConnections[(direction + 3) % 4]);
-		else tileList.Add(nullptr);
+		int32 leftT = graph.GetNeighbour(mid, (direction + 3) % 4);
+		tileList.Add(graph.GetNeighbour(leftT, (direction + 3) % 4));
 		tileList.Add(leftT);
 
 		tileList.Add(mid);
 
 		// Rightmost tiles
-		auto rightT = mid->CardinalConnections[(direction + 1) % 4];
-		if (rightT)
-			tileList.Add(rightT->CardinalConnections[(direction + 1) % 4]);
-		else tileList.Add(nullptr);
+		int32 rightT = graph.GetNeighbour(mid, (direction + 1) % 4);
+		tileList.Add(graph.GetNeighbour(rightT, (direction + 1) % 4));
 		tileList.Add(rightT);
 
-
 		// get the tile 1 ahead of each stored tile to make swipe attack 2x5
 		for (int i = 0; i < 5; ++i)
-		{
-			if (tileList[i])
-				tileList.Add(tileList[i]->CardinalConnections[direction]);
-			else tileList.Add(nullptr);
-		}
+			tileList.Add(graph.GetNeighbour(tileList[i], direction));
 	}
 
-	for (auto tile : tileList)
-		if (!tile)
-			return false;
-	return true;
+	return !tileList.Contains(INDEX_NONE);
 }
 
-bool ADungeonTormentor::GetSlamAttackTiles(int direction, TArray<ADungeonSingleTile*>& tileList)
+bool ADungeonTormentor::GetSlamAttackTileIndices(const FDungeonTileGraph& graph, int direction, TArray<int32>& tileList) const
 {
 	direction = direction % 4;
+	tileList.Reset(9);
 	// Jumps ahead 3 tiles (from middle tormentor, to tormentor edge, to in front of tormentor, to 1 tile in front of tormentor)
-	ADungeonSingleTile* mid = CurrentTile->CardinalConnections[direction];
+	int32 mid = graph.GetNeighbour(CurrentTile->TileIndex, direction);
 	for (int i = 0; i < 2; ++i)
 	{
-		mid = mid->CardinalConnections[direction];
-		if (!mid)
+		mid = graph.GetNeighbour(mid, direction);
+		if (mid == INDEX_NONE)
 			return false;
 	}
-	mid->GetSurroundingTiles(tileList);
+	int32 surrounding[8];
+	graph.GetSurroundingTiles(mid, surrounding);
+	tileList.Append(surrounding, 8);
 	tileList.Add(mid);
 	return true;
 }
 
+bool ADungeonTormentor::GetTilesDirectional(int direction, TArray<ADungeonSingleTile*>& tileList)
+{
+	tileList.Reset();
+	const FDungeonTileGraph* graph = GetTileGraph();
+	if (!graph || !CurrentTile)
+		return false;
+	TArray<int32> indices;
+	bool valid = GetTileIndicesDirectional(*graph, direction, indices);
+	graph->ToTiles(indices, tileList);
+	return valid;
+}
+
+bool ADungeonTormentor::GetSwipeAttackTiles(int direction, TArray<ADungeonSingleTile*>& tileList)
+{
+	tileList.Reset();
+	const FDungeonTileGraph* graph = GetTileGraph();
+	if (!graph || !CurrentTile)
+		return false;
+	TArray<int32> indices;
+	bool valid = GetSwipeAttackTileIndices(*graph, direction, indices);
+	graph->ToTiles(indices, tileList);
+	return valid;
+}
+
+bool ADungeonTormentor::GetSlamAttackTiles(int direction, TArray<ADungeonSingleTile*>& tileList)
+{
+	tileList.Reset();
+	const FDungeonTileGraph* graph = GetTileGraph();
+	if (!graph || !CurrentTile)
+		return false;
+	TArray<int32> indices;
+	bool valid = GetSlamAttackTileIndices(*graph, direction, indices);
+	graph->ToTiles(indices, tileList);
+	return valid;
+}
+
 void ADungeonTormentor::AttackSwipe_Implementation()
 {
 }
@@ -371,10 +420,35 @@ void ADungeonTormentor::AttackSlam_Implementation()
 bool ADungeonTormentor::SetTarget(ADungeonSingleTile* Target, bool GoForClosest)
 {
 	TArray<ADungeonSingleTile*> path;
+	// The player usually only moves a tile between repaths, so only the changed part of the search is redone.
+	const FDungeonTileGraph* graph = GetTileGraph();
+	if (bUseIncrementalPlanner && graph && Target && CurrentTile && Gamemode->ActivePlayer && Target == Gamemode->ActivePlayer->CurrentTile)
+	{
+		TArray<int32> indices;
+		if (PursuitPlanner.Plan(*graph, CurrentTile->TileIndex, Target->TileIndex, indices))
+		{
+			graph->ToTiles(indices, path);
+			DesiredPath = path;
+			Route.Reset();
+			return true;
+		}
+		// Player can't be reached, fall through so GoForClosest can still get us near them
+	}
+
+	// Targets in other rooms are planned room by room, only the path through the current room is generated up front.
+	FDungeonRoomRoute route;
+	if (Gamemode->DungeonMap->GenerateRoute(CurrentTile, Target, 3, route) && Gamemode->DungeonMap->RefineRoute(route, path))
+	{
+		DesiredPath = path;
+		Route = MoveTemp(route);
+		return true;
+	}
+
 	path = Gamemode->CallPathfinder(CurrentTile, Target, 3, GoForClosest);
 	if (path.Num() == 0)
 		return false;
 	else DesiredPath = path;
+	Route.Reset();
 	return true;
 }
 
@@ -386,7 +460,7 @@ void ADungeonTormentor::SetTile(ADungeonSingleTile* tile)
 		TArray<ADungeonSingleTile*> currentNearTiles;
 		CurrentTile->GetSurroundingTiles(currentNearTiles);
 		for (ADungeonSingleTile* nearTile : currentNearTiles)
-			if (nearTile) nearTile->OccupyingActor = nullptr;
+			if (nearTile) nearTile->SetOccupyingActor(nullptr);
 	}
 
 	Super::SetTile(tile);
@@ -398,7 +472,7 @@ void ADungeonTormentor::SetTile(ADungeonSingleTile* tile)
 	for (ADungeonSingleTile* nearTile : nearbyTiles)
 		if (nearTile)
 		{
-			nearTile->OccupyingActor = this;
+			nearTile->SetOccupyingActor(this);
 			nearTile->TileEvent.Broadcast(this, nearTile);
 		}
 }
\ No newline at end of file
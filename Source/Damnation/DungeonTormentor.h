@@ -4,6 +4,8 @@
 
 #include "DungeonTileOccupant.h"
 #include "DungeonHelpers.h"
+#include "DungeonRoomGraph.h"
+#include "DungeonIncrementalPlanner.h"
 
 //DEBUG
 #include "Kismet/KismetSystemLibrary.h"
@@ -132,6 +134,10 @@ public:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Tormentor Variables|Movement")
 	float RotateDuration = 0.5f;
 
+	// If true, paths to the player repair the previous turns' search instead of searching from scratch.
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Tormentor Variables|Movement")
+	bool bUseIncrementalPlanner = true;
+
 	// The maximum distance the tormentor can spot the player from.
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Tormentor Variables|Movement")
 	float SpotDistanceMax = 2000.0f;
@@ -156,6 +162,17 @@ protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	// Attack & dodge choices, split from the floor seed
+	FRandomStream Random;
+
+	// Gets the floors' tile graph, nullptr if there is no map.
+	const FDungeonTileGraph* GetTileGraph() const;
+
+	// Tile graph versions of the shape queries below, returning compact tile indices (INDEX_NONE where no tile exists).
+	bool GetTileIndicesDirectional(const FDungeonTileGraph& graph, int direction, TArray<int32>& tileList) const;
+	bool GetSwipeAttackTileIndices(const FDungeonTileGraph& graph, int direction, TArray<int32>& tileList) const;
+	bool GetSlamAttackTileIndices(const FDungeonTileGraph& graph, int direction, TArray<int32>& tileList) const;
+
 	bool GetTilesDirectional(int direction, TArray<ADungeonSingleTile*>& tileList);
 
 	bool GetSwipeAttackTiles(int direction, TArray<ADungeonSingleTile*>& tileList);
@@ -210,9 +227,16 @@ protected:
 	ADungeonSingleTile* LastPlayerSeenTile;
 
 	// The path to the current target, with [0] being the next desired tile and Last() being the target.
+	// When following a room-level route this only holds the path through the current room.
 	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "Tormentor Variables")
 	TArray<ADungeonSingleTile*> DesiredPath;
 
+	// Room-level route to a far target, refined into DesiredPath one room at a time.
+	FDungeonRoomRoute Route;
+
+	// Search tree kept between turns while pursuing the player
+	FDungeonIncrementalPlanner PursuitPlanner = FDungeonIncrementalPlanner(3);
+
 	// The current facing direction
 	UPROPERTY(BlueprintReadOnly, VisibleAnywhere, Category = "Tormentor Variables")
 	ECardinal Facing = ECardinal::NORTH;
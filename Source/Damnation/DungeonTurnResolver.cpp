@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DungeonTurnResolver.h"
+#include "Async/ParallelFor.h"
+
+namespace
+{
+	void DecideIntent(const FDungeonTileGraph& graph, const FDungeonFlowField& field, int32 playerTile, FDungeonEnemyIntent& intent, FDungeonTurnResolver::FFindPath findPath)
+	{
+		intent.Action = EEnemyTurnAction::WAIT;
+		intent.Target = INDEX_NONE;
+		intent.Direction = 0xFF;
+		intent.Cost = field.GetCost(intent.Tile);
+
+		// The flow field is shared by every enemy near the player, enemies further away follow their own path
+		int32 next = field.GetNextStep(graph, intent.Tile);
+		if (next == INDEX_NONE && intent.bRepath)
+		{
+			intent.Path.Reset();
+			findPath(intent.Tile, playerTile, intent.Path);
+			intent.PathStep = intent.Path.Num() > 0 ? intent.Path[0] : INDEX_NONE;
+		}
+		if (next == INDEX_NONE)
+			next = intent.PathStep;
+		if (next == INDEX_NONE || graph.IsPathingIgnored(next))
+			return;
+
+		// Paths can go stale, only step to a tile that's still connected
+		for (int32 dir = 0; dir < FDungeonTileGraph::CardinalCount; ++dir)
+			if (graph.GetNeighbour(intent.Tile, dir) == next)
+			{
+				intent.Target = next;
+				intent.Direction = (uint8)dir;
+				intent.Action = next == playerTile ? EEnemyTurnAction::ATTACK : EEnemyTurnAction::MOVE;
+				return;
+			}
+	}
+}
+
+void FDungeonTurnResolver::Decide(const FDungeonTileGraph& graph, const FDungeonFlowField& field, int32 playerTile, TArray<FDungeonEnemyIntent>& intents, FFindPath findPath)
+{
+	// Each intent is only written by its own iteration
+	ParallelFor(intents.Num(), [&](int32 i)
+	{
+		DecideIntent(graph, field, playerTile, intents[i], findPath);
+	}, intents.Num() < MinParallelIntents);
+}
+
+void FDungeonTurnResolver::GetCommitOrder(const TArray<FDungeonEnemyIntent>& intents, TArray<int32>& outOrder)
+{
+	outOrder.Reset(intents.Num());
+	for (int32 i = 0; i < intents.Num(); ++i)
+		outOrder.Add(i);
+	// Enemies outside the flow field go last. Only one enemy can stand on a tile, so ties are broken by it.
+	outOrder.Sort([&intents](int32 a, int32 b)
+	{
+		float costA = intents[a].Cost < 0.0f ? MAX_flt : intents[a].Cost;
+		float costB = intents[b].Cost < 0.0f ? MAX_flt : intents[b].Cost;
+		return costA != costB ? costA < costB : intents[a].Tile < intents[b].Tile;
+	});
+}
+
+bool FDungeonTurnResolver::CanCommit(const FDungeonTileGraph& graph, FDungeonEnemyIntent& intent)
+{
+	if (intent.Action != EEnemyTurnAction::MOVE)
+		return false;
+	// Taken by an enemy committed earlier, or by anything that was already there & didn't move away
+	if (graph.GetOccupant(intent.Target) != 0)
+	{
+		intent.Action = EEnemyTurnAction::BLOCKED;
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DungeonFlowField.h"
+#include "DungeonTurnResolver.generated.h"
+
+// What a natively moved enemy did with its turn.
+UENUM(BlueprintType)
+enum class EEnemyTurnAction : uint8
+{
+	WAIT = 0 UMETA(DisplayName = "Wait"),
+	MOVE = 1 UMETA(DisplayName = "Move"),
+	// Wanted to move, but the tile was taken first
+	BLOCKED = 2 UMETA(DisplayName = "Blocked"),
+	// Next step is the players' tile
+	ATTACK = 3 UMETA(DisplayName = "Attack")
+};
+
+// One enemies' turn, as tile indices so it can be decided off the game thread.
+struct FDungeonEnemyIntent
+{
+	// Filled in before deciding
+	// The tile the enemy stands on
+	int32 Tile = INDEX_NONE;
+	// The next tile of the enemies' own path, followed outside the flow field. INDEX_NONE if it has none.
+	int32 PathStep = INDEX_NONE;
+	// Search for a new path to the player rather than following PathStep, only used outside the flow field
+	bool bRepath = false;
+
+	// Filled in by Decide
+	EEnemyTurnAction Action = EEnemyTurnAction::WAIT;
+	// The tile moved to or attacked
+	int32 Target = INDEX_NONE;
+	// ECardinal value of the connection to Target
+	uint8 Direction = 0xFF;
+	// Cost to reach the player, negative outside the flow field
+	float Cost = -1.0f;
+	// The new path when bRepath was set, from the tile after Tile. Empty if none was found.
+	TArray<int32> Path;
+};
+
+/*
+* Resolves the turn of every natively moved enemy in two phases.
+* Decide works out each enemies' intended action from the tile graph & the player flow field alone, in parallel,
+* including the path search for any enemy outside the field that needs a new path.
+* The commit then applies the intents one at a time in a stable order, closest to the player first so the enemies
+* in front move out of the way of those behind. An intent whose tile has been taken by the time it's applied is blocked.
+*/
+struct DAMNATION_API FDungeonTurnResolver
+{
+	// Fewer intents than this are decided on the calling thread, as a parallel for costs more than it saves
+	static const int32 MinParallelIntents = 16;
+
+	// Finds a path between tile indices for an intent with bRepath, from the tile after start. Called from several threads at once.
+	typedef TFunctionRef<bool(int32 start, int32 end, TArray<int32>& outPath)> FFindPath;
+
+	// Decides every intent. graph & field are only read, so must not change until this returns.
+	static void Decide(const FDungeonTileGraph& graph, const FDungeonFlowField& field, int32 playerTile, TArray<FDungeonEnemyIntent>& intents, FFindPath findPath);
+
+	// Fills outOrder with the indices of intents in the order they're committed.
+	static void GetCommitOrder(const TArray<FDungeonEnemyIntent>& intents, TArray<int32>& outOrder);
+
+	// Checks an intent against the current state of graph, blocking the move if its tile is now occupied. Returns true if the move can go ahead.
+	static bool CanCommit(const FDungeonTileGraph& graph, FDungeonEnemyIntent& intent);
+};